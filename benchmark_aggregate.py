@@ -0,0 +1,146 @@
+#!/usr/bin/env python
+"""
+Aggregate benchmark reports of the ping test application.
+
+Every node prints its results as CSV rows tagged BENCH (layout in the
+BENCH_COLUMNS row) on the serial console, and serves the rows of the last
+run with CoAP GET coap://[node]/bench. Collect the console logs or the CoAP
+payloads of all nodes into files and pass them to this script:
+
+    python benchmark_aggregate.py node1.log node2.log ...
+
+Runs are grouped by firmware build. With two or more builds present the
+delivery ratio and latency of each build is compared against the first one
+(or the one given with --baseline).
+"""
+from __future__ import print_function
+
+import argparse
+import csv
+import sys
+from collections import OrderedDict
+
+HISTOGRAM_COLUMNS = ["h0", "h1", "h2", "h4", "h8", "h16", "h32", "h64",
+                     "h128", "h256", "h512", "h1k", "h2k", "h4k", "h8k",
+                     "h16k"]
+# Lower bound in ms of each histogram bin, the last one is open ended
+HISTOGRAM_BOUNDS = [0] + [1 << n for n in range(len(HISTOGRAM_COLUMNS) - 1)]
+# Layout of the current firmware, used when the input has no BENCH_COLUMNS
+# row, as in the CoAP payload
+DEFAULT_COLUMNS = (["BENCH_COLUMNS", "build", "node", "role", "goal", "length",
+                    "interval", "duration_ms", "flow", "tx_ok", "tx_err", "rx",
+                    "dup", "reorder", "lost", "lat_min_ms", "lat_max_ms",
+                    "lat_mean_ms"] + HISTOGRAM_COLUMNS +
+                   ["mac_tx", "mac_rx", "mac_tx_failed", "mac_tx_retry",
+                    "mac_tx_failed_cca", "mac_tx_buffer_overflow",
+                    "mac_tx_queue_peak", "ip_rx_drop", "ip_no_route",
+                    "frag_tx_errors", "rpl_parent_change", "etx_1st_parent",
+                    "heap_max", "heap_size"])
+
+
+def read_rows(paths):
+    columns = DEFAULT_COLUMNS
+    for path in paths:
+        stream = sys.stdin if path == "-" else open(path)
+        for fields in csv.reader(stream):
+            if not fields:
+                continue
+            tag = fields[0].strip()
+            if tag == "BENCH_COLUMNS":
+                columns = fields
+            elif tag == "BENCH" and len(fields) == len(columns):
+                yield dict(zip(columns[1:], fields[1:]))
+        if stream is not sys.stdin:
+            stream.close()
+
+
+def percentile(histogram, fraction):
+    total = sum(histogram)
+    if total == 0:
+        return None
+    limit = total * fraction
+    count = 0
+    for bound, value in zip(HISTOGRAM_BOUNDS, histogram):
+        count += value
+        if count >= limit:
+            return bound
+    return HISTOGRAM_BOUNDS[-1]
+
+
+def aggregate(rows):
+    builds = OrderedDict()
+    for row in rows:
+        build = builds.setdefault(row["build"], {
+            "nodes": set(), "tx_ok": 0, "tx_err": 0, "rx": 0, "dup": 0,
+            "reorder": 0, "lost": 0, "mac_tx_retry": 0,
+            "mac_tx_failed_cca": 0, "mac_tx_buffer_overflow": 0,
+            "heap_max": 0, "histogram": [0] * len(HISTOGRAM_COLUMNS)})
+        build["nodes"].add(row["node"])
+        for key in ("tx_ok", "tx_err", "rx", "dup", "reorder", "lost",
+                    "mac_tx_retry", "mac_tx_failed_cca",
+                    "mac_tx_buffer_overflow"):
+            build[key] += int(row[key])
+        build["heap_max"] = max(build["heap_max"], int(row["heap_max"]))
+        for i, column in enumerate(HISTOGRAM_COLUMNS):
+            build["histogram"][i] += int(row[column])
+    for build in builds.values():
+        expected = build["rx"] + build["lost"]
+        build["pdr"] = 100.0 * build["rx"] / expected if expected else None
+        build["p50"] = percentile(build["histogram"], 0.5)
+        build["p90"] = percentile(build["histogram"], 0.9)
+        build["p99"] = percentile(build["histogram"], 0.99)
+    return builds
+
+
+def fmt(value, suffix=""):
+    if value is None:
+        return "-"
+    if isinstance(value, float):
+        return "%.2f%s" % (value, suffix)
+    return "%s%s" % (value, suffix)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("logs", nargs="+", help="console logs or CSV files, - for stdin")
+    parser.add_argument("--baseline", help="build to compare against")
+    args = parser.parse_args()
+
+    builds = aggregate(read_rows(args.logs))
+    if not builds:
+        print("no BENCH rows found", file=sys.stderr)
+        return 1
+
+    print("%-22s %5s %8s %8s %6s %6s %8s %6s %6s %6s %8s %8s" % (
+        "build", "nodes", "tx", "rx", "dup", "lost", "pdr", "p50", "p90",
+        "p99", "retries", "heap_max"))
+    for name, build in builds.items():
+        print("%-22s %5d %8d %8d %6d %6d %8s %6s %6s %6s %8d %8d" % (
+            name, len(build["nodes"]), build["tx_ok"], build["rx"],
+            build["dup"], build["lost"], fmt(build["pdr"], "%"),
+            fmt(build["p50"]), fmt(build["p90"]), fmt(build["p99"]),
+            build["mac_tx_retry"], build["heap_max"]))
+
+    if len(builds) > 1:
+        baseline_name = args.baseline or next(iter(builds))
+        if baseline_name not in builds:
+            print("unknown baseline build %s" % baseline_name, file=sys.stderr)
+            return 1
+        baseline = builds[baseline_name]
+        print("\ncompared to %s:" % baseline_name)
+        for name, build in builds.items():
+            if name == baseline_name:
+                continue
+            delta_pdr = None
+            if build["pdr"] is not None and baseline["pdr"] is not None:
+                delta_pdr = build["pdr"] - baseline["pdr"]
+            delta_p90 = None
+            if build["p90"] is not None and baseline["p90"] is not None:
+                delta_p90 = build["p90"] - baseline["p90"]
+            print("  %-22s pdr %s  p90 %s ms" % (name, fmt(delta_pdr, "%"), fmt(delta_p90)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include "ns_types.h"
+#include "coap-service/coap_service_api.h"
+#include "benchmark_coap.h"
+
+#define BENCHMARK_COAP_RESOURCES_MAX    4
+#define BENCHMARK_COAP_PAYLOAD_MAX      1024
+
+typedef struct {
+    const char *uri;
+    uint16_t content_format;
+    benchmark_coap_format_cb *format_cb;
+} benchmark_coap_resource_t;
+
+static int8_t service_id = -1;
+static benchmark_coap_resource_t resources[BENCHMARK_COAP_RESOURCES_MAX];
+/* Responses are built on the event loop thread one at a time */
+static char payload[BENCHMARK_COAP_PAYLOAD_MAX];
+
+static benchmark_coap_resource_t *resource_find(const uint8_t *uri, uint16_t uri_len)
+{
+    for (int i = 0; i < BENCHMARK_COAP_RESOURCES_MAX; i++) {
+        if (resources[i].uri &&
+                strlen(resources[i].uri) == uri_len &&
+                memcmp(resources[i].uri, uri, uri_len) == 0) {
+            return &resources[i];
+        }
+    }
+    return NULL;
+}
+
+static int request_recv_cb(int8_t service, uint8_t source_address[static 16], uint16_t source_port, sn_coap_hdr_s *request_ptr)
+{
+    (void)source_address;
+    (void)source_port;
+
+    benchmark_coap_resource_t *resource = resource_find(request_ptr->uri_path_ptr, request_ptr->uri_path_len);
+    if (!resource) {
+        coap_service_response_send(service, COAP_REQUEST_OPTIONS_NONE, request_ptr,
+                                   COAP_MSG_CODE_RESPONSE_NOT_FOUND, COAP_CT_NONE, NULL, 0);
+        return 0;
+    }
+
+    int length = resource->format_cb(payload, sizeof(payload));
+    if (length < 0) {
+        coap_service_response_send(service, COAP_REQUEST_OPTIONS_NONE, request_ptr,
+                                   COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR, COAP_CT_NONE, NULL, 0);
+        return 0;
+    }
+
+    coap_service_response_send(service, COAP_REQUEST_OPTIONS_NONE, request_ptr,
+                               COAP_MSG_CODE_RESPONSE_CONTENT, (sn_coap_content_format_e)resource->content_format,
+                               (const uint8_t *)payload, (uint16_t)length);
+    return 0;
+}
+
+int benchmark_coap_register(const char *uri, uint16_t content_format, benchmark_coap_format_cb *format_cb)
+{
+    if (service_id < 0 || !uri || !format_cb) {
+        return -1;
+    }
+
+    for (int i = 0; i < BENCHMARK_COAP_RESOURCES_MAX; i++) {
+        if (!resources[i].uri) {
+            if (coap_service_register_uri(service_id, uri, COAP_SERVICE_ACCESS_GET_ALLOWED, request_recv_cb) < 0) {
+                return -1;
+            }
+            resources[i].uri = uri;
+            resources[i].content_format = content_format;
+            resources[i].format_cb = format_cb;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int benchmark_coap_init(uint16_t port, const char *uri, benchmark_coap_format_cb *format_cb)
+{
+    if (service_id < 0) {
+        /* Interface id only matters with COAP_SERVICE_OPTIONS_SELECT_SOCKET_IF */
+        service_id = coap_service_initialize(0, port, COAP_SERVICE_OPTIONS_NONE, NULL, NULL);
+        if (service_id < 0) {
+            return -1;
+        }
+    }
+    return benchmark_coap_register(uri, BENCHMARK_COAP_TEXT_PLAIN, format_cb);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BENCHMARK_COAP_H
+#define BENCHMARK_COAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CoAP Content-Formats of the served resources */
+#define BENCHMARK_COAP_TEXT_PLAIN       0
+#define BENCHMARK_COAP_OCTET_STREAM     42
+
+/**
+ * Resource formatter, writes the resource representation to buffer.
+ * Returns the number of bytes written or negative on failure.
+ */
+typedef int benchmark_coap_format_cb(char *buffer, size_t length);
+
+/**
+ * Open a CoAP service on the given port and serve uri with GET.
+ *
+ * coap_service_api.h cannot be included from C++, so the CoAP glue for
+ * the benchmark lives in C. Must be called with the Nanostack event loop
+ * mutex held.
+ *
+ * \return 0 on success, negative on failure
+ */
+int benchmark_coap_init(uint16_t port, const char *uri, benchmark_coap_format_cb *format_cb);
+
+/**
+ * Register an additional GET resource on the service opened by
+ * benchmark_coap_init(). Must be called with the Nanostack event loop
+ * mutex held.
+ *
+ * \param content_format BENCHMARK_COAP_TEXT_PLAIN or BENCHMARK_COAP_OCTET_STREAM
+ * \return 0 on success, negative on failure
+ */
+int benchmark_coap_register(const char *uri, uint16_t content_format, benchmark_coap_format_cb *format_cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "rtos.h"
+#include "us_ticker_api.h"
+#include "eventOS_scheduler.h"
+#include "nsdynmemLIB.h"
+#include "NanostackInterface.h"
+#include "benchmark_report.h"
+#include "benchmark_coap.h"
+
+/*
+ * Results are reported as CSV, one row per flow. The first column tags
+ * the row so that the lines can be picked out of a console log; the
+ * column layout is printed once per report in a BENCH_COLUMNS row.
+ *
+ * Node clocks are not synchronised. Latency is the one-way transit time
+ * relative to the first packet of the flow, i.e. it measures the queuing
+ * and forwarding delay added on top of the fastest observed path.
+ */
+#define BENCHMARK_REPLAY_WINDOW     32
+
+static const char benchmark_columns[] =
+    "BENCH_COLUMNS,build,node,role,goal,length,interval,duration_ms,flow,"
+    "tx_ok,tx_err,rx,dup,reorder,lost,lat_min_ms,lat_max_ms,lat_mean_ms,"
+    "h0,h1,h2,h4,h8,h16,h32,h64,h128,h256,h512,h1k,h2k,h4k,h8k,h16k,"
+    "mac_tx,mac_rx,mac_tx_failed,mac_tx_retry,mac_tx_failed_cca,"
+    "mac_tx_buffer_overflow,mac_tx_queue_peak,ip_rx_drop,ip_no_route,"
+    "frag_tx_errors,rpl_parent_change,etx_1st_parent,heap_max,heap_size";
+
+typedef struct {
+    uint8_t address[16];
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t reordered;
+    long highest_seq;
+    uint32_t window;
+    uint32_t offset_base;
+    int32_t latency_min;
+    int32_t latency_max;
+    uint64_t latency_sum;
+    uint32_t histogram[BENCHMARK_LATENCY_BINS];
+} benchmark_flow_t;
+
+typedef struct {
+    benchmark_role_t role;
+    long goal;
+    int length;
+    int interval;
+    uint32_t duration_ms;
+    uint32_t tx_ok;
+    uint32_t tx_err;
+    uint8_t flow_count;
+    benchmark_flow_t flows[BENCHMARK_MAX_FLOWS];
+    nwk_stats_t nwk_stats;
+    uint32_t heap_max;
+    uint32_t heap_size;
+} benchmark_run_t;
+
+static NetworkInterface *network_if;
+static Mutex report_mutex;
+static Timer run_timer;
+static benchmark_run_t current;
+static benchmark_run_t finished;
+static bool finished_valid;
+
+static int benchmark_coap_format(char *buffer, size_t length)
+{
+    return benchmark_report_csv(buffer, length);
+}
+
+void benchmark_report_init(NetworkInterface *interface)
+{
+    network_if = interface;
+
+    eventOS_scheduler_mutex_wait();
+    if (benchmark_coap_init(BENCHMARK_COAP_PORT, BENCHMARK_COAP_URI, benchmark_coap_format) < 0) {
+        printf("benchmark: CoAP resource not available\n");
+    }
+    eventOS_scheduler_mutex_release();
+}
+
+void benchmark_report_start(benchmark_role_t role, long goal, int length, int interval)
+{
+    eventOS_scheduler_mutex_wait();
+    protocol_stats_reset();
+    eventOS_scheduler_mutex_release();
+
+    report_mutex.lock();
+    memset(&current, 0, sizeof(current));
+    current.role = role;
+    current.goal = goal;
+    current.length = length;
+    current.interval = interval;
+    run_timer.reset();
+    run_timer.start();
+    report_mutex.unlock();
+}
+
+void benchmark_report_tx(int result)
+{
+    report_mutex.lock();
+    if (result >= 0) {
+        current.tx_ok++;
+    } else {
+        current.tx_err++;
+    }
+    report_mutex.unlock();
+}
+
+static benchmark_flow_t *flow_get(const uint8_t address[16])
+{
+    for (uint8_t i = 0; i < current.flow_count; i++) {
+        if (memcmp(current.flows[i].address, address, 16) == 0) {
+            return &current.flows[i];
+        }
+    }
+    if (current.flow_count == BENCHMARK_MAX_FLOWS) {
+        return NULL;
+    }
+    benchmark_flow_t *flow = &current.flows[current.flow_count++];
+    memcpy(flow->address, address, 16);
+    return flow;
+}
+
+static uint8_t latency_bin(int32_t latency_ms)
+{
+    uint8_t bin = 0;
+    while (latency_ms > 0 && bin < BENCHMARK_LATENCY_BINS - 1) {
+        latency_ms >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+void benchmark_report_rx(const SocketAddress &source, long seq, uint32_t tx_timestamp, uint32_t rx_timestamp)
+{
+    uint32_t offset = rx_timestamp - tx_timestamp;
+
+    report_mutex.lock();
+    benchmark_flow_t *flow = flow_get((const uint8_t *)source.get_ip_bytes());
+    if (!flow) {
+        report_mutex.unlock();
+        return;
+    }
+
+    /* Sliding window over the last sequence numbers, as for replay protection */
+    if (flow->received == 0 || seq > flow->highest_seq) {
+        long shift = flow->received ? seq - flow->highest_seq : BENCHMARK_REPLAY_WINDOW;
+        flow->window = shift >= BENCHMARK_REPLAY_WINDOW ? 0 : flow->window << shift;
+        flow->window |= 1;
+        flow->highest_seq = seq;
+    } else {
+        long age = flow->highest_seq - seq;
+        if (age < BENCHMARK_REPLAY_WINDOW && (flow->window & (1UL << age))) {
+            flow->duplicates++;
+            report_mutex.unlock();
+            return;
+        }
+        if (age < BENCHMARK_REPLAY_WINDOW) {
+            flow->window |= 1UL << age;
+        }
+        flow->reordered++;
+    }
+
+    if (flow->received == 0) {
+        flow->offset_base = offset;
+    }
+    int32_t latency_ms = (int32_t)(offset - flow->offset_base) / 1000;
+    if (flow->received == 0 || latency_ms < flow->latency_min) {
+        flow->latency_min = latency_ms;
+    }
+    if (flow->received == 0 || latency_ms > flow->latency_max) {
+        flow->latency_max = latency_ms;
+    }
+    flow->latency_sum += latency_ms > 0 ? latency_ms : 0;
+    flow->histogram[latency_bin(latency_ms)]++;
+    flow->received++;
+    report_mutex.unlock();
+}
+
+void benchmark_report_nwk_stats(nwk_stats_t *stats)
+{
+    /* Collection is started by the Nanostack interface */
+    NanostackInterface::get_nwk_stats(stats);
+}
+
+void benchmark_report_finish(void)
+{
+    nwk_stats_t stats;
+    const mem_stat_t *heap;
+
+    eventOS_scheduler_mutex_wait();
+    NanostackInterface::get_nwk_stats(&stats);
+    heap = ns_dyn_mem_get_mem_stat();
+    eventOS_scheduler_mutex_release();
+
+    report_mutex.lock();
+    run_timer.stop();
+    current.duration_ms = run_timer.read_ms();
+    current.nwk_stats = stats;
+    current.heap_max = heap ? heap->heap_sector_allocated_bytes_max : 0;
+    current.heap_size = heap ? heap->heap_sector_size : 0;
+    finished = current;
+    finished_valid = true;
+    report_mutex.unlock();
+
+    static char buffer[1024];
+    benchmark_report_csv(buffer, sizeof(buffer));
+    printf("%s\n%s", benchmark_columns, buffer);
+}
+
+static int format_row(char *buffer, size_t length, const char *node, const benchmark_flow_t *flow)
+{
+    const benchmark_run_t *run = &finished;
+    const nwk_stats_t *stats = &run->nwk_stats;
+    char flow_str[40] = "-";
+    uint32_t received = 0, duplicates = 0, reordered = 0, lost = 0;
+    int32_t lat_min = 0, lat_max = 0, lat_mean = 0;
+    static const uint32_t no_histogram[BENCHMARK_LATENCY_BINS] = {0};
+    const uint32_t *histogram = no_histogram;
+
+    if (flow) {
+        SocketAddress source(flow->address, NSAPI_IPv6);
+        strncpy(flow_str, source.get_ip_address(), sizeof(flow_str) - 1);
+        received = flow->received;
+        duplicates = flow->duplicates;
+        reordered = flow->reordered;
+        long expected = flow->highest_seq > run->goal ? flow->highest_seq : run->goal;
+        lost = expected > (long)received ? expected - received : 0;
+        lat_min = flow->latency_min;
+        lat_max = flow->latency_max;
+        lat_mean = received ? (int32_t)(flow->latency_sum / received) : 0;
+        histogram = flow->histogram;
+    }
+
+    int written = snprintf(buffer, length,
+                           "BENCH,%s %s,%s,%s,%ld,%d,%d,%lu,%s,%lu,%lu,%lu,%lu,%lu,%lu,%ld,%ld,%ld,",
+                           __DATE__, __TIME__, node,
+                           run->role == BENCHMARK_ROLE_SENDER ? "tx" : "rx",
+                           run->goal, run->length, run->interval,
+                           (unsigned long)run->duration_ms, flow_str,
+                           (unsigned long)run->tx_ok, (unsigned long)run->tx_err,
+                           (unsigned long)received, (unsigned long)duplicates,
+                           (unsigned long)reordered, (unsigned long)lost,
+                           (long)lat_min, (long)lat_max, (long)lat_mean);
+    for (int i = 0; i < BENCHMARK_LATENCY_BINS; i++) {
+        if (written < 0 || (size_t)written >= length) {
+            return -1;
+        }
+        written += snprintf(buffer + written, length - written, "%lu,", (unsigned long)histogram[i]);
+    }
+    if (written < 0 || (size_t)written >= length) {
+        return -1;
+    }
+    written += snprintf(buffer + written, length - written,
+                        "%lu,%lu,%lu,%lu,%lu,%u,%u,%lu,%lu,%lu,%lu,%u,%lu,%lu\n",
+                        (unsigned long)stats->mac_tx_count, (unsigned long)stats->mac_rx_count,
+                        (unsigned long)stats->mac_tx_failed, (unsigned long)stats->mac_tx_retry,
+                        (unsigned long)stats->mac_tx_failed_cca,
+                        stats->mac_tx_buffer_overflow, stats->mac_tx_queue_peak,
+                        (unsigned long)stats->ip_rx_drop, (unsigned long)stats->ip_no_route,
+                        (unsigned long)stats->frag_tx_errors,
+                        (unsigned long)stats->rpl_route_routecost_better_change,
+                        stats->etx_1st_parent,
+                        (unsigned long)run->heap_max, (unsigned long)run->heap_size);
+    if (written < 0 || (size_t)written >= length) {
+        return -1;
+    }
+    return written;
+}
+
+int benchmark_report_csv(char *buffer, size_t length)
+{
+    const char *node = "-";
+    int written = 0;
+
+    if (length == 0) {
+        return -1;
+    }
+    buffer[0] = '\0';
+
+    if (network_if && network_if->get_ip_address()) {
+        node = network_if->get_ip_address();
+    }
+
+    report_mutex.lock();
+    if (!finished_valid) {
+        report_mutex.unlock();
+        return 0;
+    }
+    if (finished.flow_count == 0) {
+        int row = format_row(buffer, length, node, NULL);
+        written = row > 0 ? row : 0;
+    }
+    for (uint8_t i = 0; i < finished.flow_count; i++) {
+        /* Rows that do not fit are left out whole */
+        int row = format_row(buffer + written, length - written, node, &finished.flows[i]);
+        if (row < 0) {
+            buffer[written] = '\0';
+            break;
+        }
+        written += row;
+    }
+    report_mutex.unlock();
+
+    return written;
+}
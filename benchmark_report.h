@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BENCHMARK_REPORT_H
+#define BENCHMARK_REPORT_H
+
+#include "NetworkInterface.h"
+#include "SocketAddress.h"
+#include "nanostack/nwk_stats_api.h"
+
+/* Number of distinct sources tracked per run */
+#define BENCHMARK_MAX_FLOWS         4
+/* Latency histogram bins, bin n holds latencies in [2^(n-1), 2^n) ms */
+#define BENCHMARK_LATENCY_BINS      16
+/* CoAP resource serving the last finished report */
+#define BENCHMARK_COAP_PORT         5683
+#define BENCHMARK_COAP_URI          "bench"
+
+typedef enum {
+    BENCHMARK_ROLE_RECEIVER = 0,
+    BENCHMARK_ROLE_SENDER = 1
+} benchmark_role_t;
+
+/**
+ * Prepare the benchmark module. Enables Nanostack statistics collection
+ * and registers the CoAP GET resource.
+ */
+void benchmark_report_init(NetworkInterface *interface);
+
+/**
+ * Start a new run. Clears flows and snapshots the network statistics.
+ *
+ * \param role Role of this node in the run.
+ * \param goal Number of packets the sender is going to send.
+ * \param length Payload padding length configured on the sender.
+ * \param interval Send interval in seconds.
+ */
+void benchmark_report_start(benchmark_role_t role, long goal, int length, int interval);
+
+/** Account a transmitted packet; result is the sendto() return value. */
+void benchmark_report_tx(int result);
+
+/**
+ * Account a received benchmark packet.
+ *
+ * \param source Sender address, identifies the flow.
+ * \param seq Sequence number carried in the packet.
+ * \param tx_timestamp Sender us_ticker value carried in the packet.
+ * \param rx_timestamp Own us_ticker value when the packet was received.
+ */
+void benchmark_report_rx(const SocketAddress &source, long seq, uint32_t tx_timestamp, uint32_t rx_timestamp);
+
+/** Copy the network statistics collected since the run was started. */
+void benchmark_report_nwk_stats(nwk_stats_t *stats);
+
+/** Finish the run, snapshot statistics and print the CSV report. */
+void benchmark_report_finish(void);
+
+/**
+ * Format the last finished report as CSV.
+ *
+ * \return Number of characters written, excluding terminating NUL.
+ */
+int benchmark_report_csv(char *buffer, size_t length);
+
+#endif
@@ -18,6 +18,8 @@
 #include "rtos.h"
 #include "NanostackInterface.h"
 #include "mbed-trace/mbed_trace.h"
+#include "eventOS_scheduler.h"
+#include "eventOS_event_timer.h"
 
 #if MBED_CONF_APP_ENABLE_LED_CONTROL_EXAMPLE
 #include "mesh_led_control_example.h"
@@ -55,6 +57,63 @@ ThreadInterface mesh;
 #endif //MBED_CONF_APP_MESH_TYPE
 
 static Mutex SerialOutMutex;
+static Semaphore address_ready(0);
+
+// Called from the Nanostack event loop thread, must not block
+static void mesh_status_changed(mesh_connection_status_t status)
+{
+    if (status == MESH_GLOBAL_ADDRESS_READY) {
+        address_ready.release();
+    }
+}
+
+static void print_bootstrap_timeline()
+{
+    mesh_bootstrap_event_t events[MBED_CONF_MBED_MESH_API_BOOTSTRAP_TIMELINE_SIZE];
+    int count = mesh.get_bootstrap_timeline(events, MBED_CONF_MBED_MESH_API_BOOTSTRAP_TIMELINE_SIZE);
+
+    for (int i = 0; i < count; i++) {
+        printf("BOOTSTRAP,%s,%lu\n", MeshInterfaceNanostack::get_bootstrap_phase_name(events[i].phase),
+               (unsigned long)events[i].time_ms);
+    }
+}
+
+static void print_pool_stats(const char *name, const eventOS_pool_stats_t &stats)
+{
+    printf("%s,size,%u,used,%u,high_water,%u,slabs,%u,failures,%u\n", name, stats.size, stats.used,
+           stats.high_water, stats.slabs, stats.failures);
+}
+
+// Event and system timer storage pool usage since power up
+static void print_pools()
+{
+    eventOS_pool_stats_t events, timers;
+
+    eventOS_event_pool_stats_get(&events);
+    eventOS_event_timer_pool_stats_get(&timers);
+    print_pool_stats("EVENT_POOL", events);
+    print_pool_stats("TIMER_POOL", timers);
+}
+
+#if MBED_CONF_NANOSTACK_EVENTLOOP_PROFILING
+// Scheduler statistics of every tasklet since the previous print
+static void print_tasklet_stats()
+{
+    eventOS_tasklet_stats_t stats;
+
+    eventOS_scheduler_mutex_wait();
+    for (int8_t id = 0; id < INT8_MAX; id++) {
+        if (eventOS_scheduler_tasklet_stats_get(id, &stats) == 0) {
+            printf("TASKLET,%d,%lu,%lu,%lu,%lu,%lu,%lu\n", id, (unsigned long)stats.events,
+                   (unsigned long)stats.run_total_us, (unsigned long)stats.run_max_us,
+                   (unsigned long)stats.delayed_events, (unsigned long)stats.delay_total_us,
+                   (unsigned long)stats.delay_max_us);
+        }
+    }
+    eventOS_scheduler_tasklet_stats_reset();
+    eventOS_scheduler_mutex_release();
+}
+#endif
 
 void serial_out_mutex_wait()
 {
@@ -68,6 +127,11 @@ void serial_out_mutex_release()
 
 int main()
 {
+    // Connect time breakdown, printed as a CONNECT_TIME line for the soak test logs
+    Timer connect_timer;
+    int power_up_ms, radio_init_ms, connect_ms, address_ms;
+    connect_timer.start();
+
     int baud = 115200;
     pc.baud(baud);
     printf("setting baudrate %d\n",baud);
@@ -76,7 +140,8 @@ int main()
     mbed_trace_mutex_wait_function_set( serial_out_mutex_wait );
     mbed_trace_mutex_release_function_set( serial_out_mutex_release );
     
-    wait_ms(500);	// wait for on board DC/DC start-up time
+    wait_ms(MBED_CONF_APP_DCDC_STARTUP_DELAY_MS);	// wait for on board DC/DC start-up time
+    power_up_ms = connect_timer.read_ms();
 
 #ifdef MBED_CONF_RTOS_PRESENT
     printf("[ ARM MBED Enabled Device ]\n");
@@ -97,18 +162,32 @@ int main()
 #endif
 
     printf("\n\nConnecting...\n");
+    int phase_start = connect_timer.read_ms();
     mesh.initialize(&rf_phy);
+    radio_init_ms = connect_timer.read_ms() - phase_start;
 
+    // connect() returns when the network scan and attach have completed
+    phase_start = connect_timer.read_ms();
+    mesh.attach(mesh_status_changed);
     int error = mesh.connect();
     if (error) {
         printf("Connection failed! %d\n", error);
         return error;
     }
+    connect_ms = connect_timer.read_ms() - phase_start;
 
-    while (NULL == mesh.get_ip_address())
-        Thread::wait(500);
+    phase_start = connect_timer.read_ms();
+    address_ready.wait(osWaitForever);
+    address_ms = connect_timer.read_ms() - phase_start;
 
     printf("connected. IP = %s\n", mesh.get_ip_address());
+    printf("CONNECT_TIME,power_up_ms,%d,radio_init_ms,%d,scan_attach_ms,%d,address_ms,%d,total_ms,%d\n",
+           power_up_ms, radio_init_ms, connect_ms, address_ms, connect_timer.read_ms());
+    print_bootstrap_timeline();
+    print_pools();
+#if MBED_CONF_NANOSTACK_EVENTLOOP_PROFILING
+    print_tasklet_stats();
+#endif
 
 #if MBED_CONF_APP_ENABLE_LED_CONTROL_EXAMPLE
     // Network found, start socket example
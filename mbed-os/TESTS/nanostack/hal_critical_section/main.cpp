@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Time interrupts are held off by Nanostack, in the critical section mode
+ * selected by nanostack-hal configuration. A Ticker measures how late its
+ * interrupt runs, first with the stack idle and then while a tasklet keeps
+ * the event queue, the system timers, the callback timers and the heap
+ * busy. The worst case difference is the interrupt-off time the stack
+ * adds: with critical_section_usable_from_interrupt every Nanostack
+ * critical section masks interrupts and the callback timers run in
+ * interrupt context. Both are printed as histograms and the difference is
+ * checked against MAX_IRQ_OFF_US.
+ */
+#if !defined(MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_THREAD_STACK_SIZE)
+#error [NOT_SUPPORTED] Nanostack HAL not enabled
+#endif
+
+// Include before mbed.h to properly get UINT*_C()
+#include "ns_types.h"
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+#include "ns_hal_init.h"
+#include "nsdynmemLIB.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "eventOS_callback_timer.h"
+#include "eventOS_scheduler.h"
+
+using namespace utest::v1;
+
+#define PROBE_US            250
+#define IDLE_MS             2000
+#define LOAD_MS             5000
+#define HEAP_SIZE           8192
+#define LOAD_TIMERS         32      // periodic system timers, 1 to 5 ticks
+#define LOAD_CALLBACK_TIMERS 4      // callback timers, 2 to 40 slots
+#define LOAD_ALLOCS         16      // heap blocks per event
+// A few MAC backoff slots of 50 us, more would upset the MAC timing
+#define MAX_IRQ_OFF_US      200
+
+static const uint32_t bucket_limits_us[] = { 5, 10, 25, 50, 100, 200, 500, 1000 };
+#define BUCKETS             (sizeof bucket_limits_us / sizeof bucket_limits_us[0] + 1)
+
+typedef struct {
+    uint32_t count[BUCKETS];
+    uint32_t samples;
+    uint32_t max_us;
+    uint64_t total_us;
+} histogram_t;
+
+enum {
+    LOAD_INIT,
+    LOAD_TIMER,
+    LOAD_SEND,
+    LOAD_STOP,
+};
+
+static Ticker probe;
+static volatile uint32_t probe_due_us;
+static histogram_t *volatile probe_histogram;
+
+static int8_t load_tasklet = -1;
+static arm_event_storage_t *load_timers[LOAD_TIMERS];
+static volatile bool load_running;
+static volatile uint32_t load_events;
+static volatile uint32_t load_callbacks;
+
+static void histogram_add(histogram_t *histogram, uint32_t latency_us)
+{
+    uint8_t bucket = 0;
+    while (bucket < BUCKETS - 1 && latency_us >= bucket_limits_us[bucket]) {
+        bucket++;
+    }
+    histogram->count[bucket]++;
+    histogram->samples++;
+    histogram->total_us += latency_us;
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us;
+    }
+}
+
+static void histogram_print(const char *name, const histogram_t *histogram)
+{
+    printf("%s: %lu samples, mean %lu us, max %lu us\r\n", name, (unsigned long) histogram->samples,
+           (unsigned long) (histogram->samples ? histogram->total_us / histogram->samples : 0),
+           (unsigned long) histogram->max_us);
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+        if (bucket < BUCKETS - 1) {
+            printf("  < %4lu us: %lu\r\n", (unsigned long) bucket_limits_us[bucket], (unsigned long) histogram->count[bucket]);
+        } else {
+            printf("  >=%4lu us: %lu\r\n", (unsigned long) bucket_limits_us[bucket - 1], (unsigned long) histogram->count[bucket]);
+        }
+    }
+}
+
+/* Ticker deadlines follow each other exactly, so lateness is kept apart from the period */
+static void probe_tick(void)
+{
+    int32_t late_us = (int32_t) (us_ticker_read() - probe_due_us);
+    histogram_t *histogram = probe_histogram;
+    if (histogram) {
+        histogram_add(histogram, late_us > 0 ? late_us : 0);
+    }
+    probe_due_us += PROBE_US;
+}
+
+static void load_heap(void)
+{
+    void *blocks[LOAD_ALLOCS];
+    for (int i = 0; i < LOAD_ALLOCS; i++) {
+        blocks[i] = ns_dyn_mem_alloc(16 + rand() % 128);
+    }
+    for (int i = 0; i < LOAD_ALLOCS; i++) {
+        if (blocks[i]) {
+            ns_dyn_mem_free(blocks[i]);
+        }
+    }
+}
+
+/* Interrupt context with critical_section_usable_from_interrupt */
+static void load_callback_timer(int8_t timer_id, uint16_t slots)
+{
+    (void) slots;
+    if (load_running) {
+        load_callbacks++;
+        eventOS_callback_timer_start(timer_id, 2 + (load_callbacks * 7 + timer_id) % 39);
+    }
+}
+
+static void load_event(arm_event_t *event, uint8_t event_type, arm_library_event_priority_e priority)
+{
+    memset(event, 0, sizeof *event);
+    event->receiver = load_tasklet;
+    event->sender = load_tasklet;
+    event->event_type = event_type;
+    event->priority = priority;
+}
+
+static void load_handler(arm_event_t *event)
+{
+    arm_event_t send;
+    load_event(&send, LOAD_SEND, ARM_LIB_MED_PRIORITY_EVENT);
+
+    switch (event->event_type) {
+        case LOAD_INIT:
+            for (int i = 0; i < LOAD_TIMERS; i++) {
+                arm_event_t timer_event;
+                load_event(&timer_event, LOAD_TIMER, ARM_LIB_MED_PRIORITY_EVENT);
+                load_timers[i] = eventOS_event_timer_request_every(&timer_event, 1 + i % 5);
+            }
+            for (int i = 0; i < LOAD_CALLBACK_TIMERS; i++) {
+                int8_t timer_id = eventOS_callback_timer_register(load_callback_timer);
+                if (timer_id >= 0) {
+                    eventOS_callback_timer_start(timer_id, 2 + i * 10);
+                }
+            }
+            break;
+        case LOAD_TIMER:
+            if (load_running) {
+                load_events++;
+                load_heap();
+                eventOS_event_send(&send);
+            }
+            break;
+        case LOAD_SEND:
+            load_heap();
+            break;
+        case LOAD_STOP:
+            for (int i = 0; i < LOAD_TIMERS; i++) {
+                if (load_timers[i]) {
+                    eventOS_cancel(load_timers[i]);
+                    load_timers[i] = NULL;
+                }
+            }
+            break;
+    }
+}
+
+static void measure(const char *name, histogram_t *histogram, uint32_t ms)
+{
+    memset(histogram, 0, sizeof *histogram);
+    probe_histogram = histogram;
+    wait_ms(ms);
+    probe_histogram = NULL;
+    histogram_print(name, histogram);
+}
+
+void test_irq_off_time()
+{
+#if MBED_CONF_NANOSTACK_HAL_CRITICAL_SECTION_USABLE_FROM_INTERRUPT
+    const char *name = "Nanostack load, interrupt critical sections";
+#else
+    const char *name = "Nanostack load, mutex critical sections";
+#endif
+    histogram_t idle, load;
+
+    probe_due_us = us_ticker_read() + PROBE_US;
+    probe.attach_us(probe_tick, PROBE_US);
+    measure("idle", &idle, IDLE_MS);
+
+    load_running = true;
+    eventOS_scheduler_mutex_wait();
+    load_tasklet = eventOS_event_handler_create(load_handler, LOAD_INIT);
+    eventOS_scheduler_mutex_release();
+    TEST_ASSERT_MESSAGE(load_tasklet >= 0, "Load tasklet not created");
+    measure(name, &load, LOAD_MS);
+    load_running = false;
+
+    arm_event_t stop;
+    load_event(&stop, LOAD_STOP, ARM_LIB_HIGH_PRIORITY_EVENT);
+    eventOS_event_send(&stop);
+    probe.detach();
+
+    TEST_ASSERT_MESSAGE(load_events > 0, "Load did not run");
+    uint32_t irq_off_us = load.max_us > idle.max_us ? load.max_us - idle.max_us : 0;
+    printf("worst case interrupt-off time: %lu us, %lu events, %lu callback timers\r\n",
+           (unsigned long) irq_off_us, (unsigned long) load_events, (unsigned long) load_callbacks);
+    TEST_ASSERT_MESSAGE(irq_off_us <= MAX_IRQ_OFF_US, "Interrupts held off too long");
+}
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(60, "default_auto");
+    ns_hal_init(NULL, HEAP_SIZE, NULL, NULL);
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Interrupt-off time", test_irq_off_time),
+};
+
+Specification specification(greentea_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Latency of the Nanostack high resolution timer (platform_timer_*), from
+ * the programmed deadline to its callback, in the callback mode selected by
+ * nanostack-hal configuration. A bare Timeout is measured the same way as
+ * the reference. Both are printed as histograms. The test takes the
+ * timer over from the eventOS callback timers.
+ */
+#if !defined(MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_THREAD_STACK_SIZE)
+#error [NOT_SUPPORTED] Nanostack HAL not enabled
+#endif
+
+// Include before mbed.h to properly get UINT*_C()
+#include "ns_types.h"
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+#include "ns_hal_init.h"
+#include "platform/arm_hal_timer.h"
+#include "platform/arm_hal_interrupt.h"
+
+using namespace utest::v1;
+
+#define SAMPLES             500
+#define SLOT_US             50
+#define MAX_SLOTS           40      // 2 ms
+#define HEAP_SIZE           4096
+
+static const uint32_t bucket_limits_us[] = { 10, 25, 50, 100, 200, 500, 1000, 2000 };
+#define BUCKETS             (sizeof bucket_limits_us / sizeof bucket_limits_us[0] + 1)
+
+static Timer timer;
+static Timeout timeout;
+static Semaphore fired(0);
+static volatile uint32_t fired_us;
+
+typedef struct {
+    uint32_t count[BUCKETS];
+    uint32_t max_us;
+    uint64_t total_us;
+} histogram_t;
+
+static void histogram_add(histogram_t *histogram, uint32_t latency_us)
+{
+    uint8_t bucket = 0;
+    while (bucket < BUCKETS - 1 && latency_us >= bucket_limits_us[bucket]) {
+        bucket++;
+    }
+    histogram->count[bucket]++;
+    histogram->total_us += latency_us;
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us;
+    }
+}
+
+static void histogram_print(const char *name, const histogram_t *histogram)
+{
+    printf("%s: mean %lu us, max %lu us\r\n", name,
+           (unsigned long) (histogram->total_us / SAMPLES), (unsigned long) histogram->max_us);
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+        if (bucket < BUCKETS - 1) {
+            printf("  < %4lu us: %lu\r\n", (unsigned long) bucket_limits_us[bucket], (unsigned long) histogram->count[bucket]);
+        } else {
+            printf("  >=%4lu us: %lu\r\n", (unsigned long) bucket_limits_us[bucket - 1], (unsigned long) histogram->count[bucket]);
+        }
+    }
+}
+
+static void callback(void)
+{
+    fired_us = timer.read_us();
+    fired.release();
+}
+
+/* Time from the deadline to the callback, negative if early */
+static int32_t measure(bool platform, uint16_t slots)
+{
+    uint32_t start_us;
+
+    if (platform) {
+        platform_enter_critical();
+        start_us = timer.read_us();
+        platform_timer_start(slots);
+        platform_exit_critical();
+    } else {
+        start_us = timer.read_us();
+        timeout.attach_us(callback, slots * SLOT_US);
+    }
+    TEST_ASSERT_MESSAGE(fired.wait(100) > 0, "Timer callback not called");
+    return (int32_t) (fired_us - start_us - slots * SLOT_US);
+}
+
+static void run(bool platform, const char *name)
+{
+    histogram_t histogram;
+    memset(&histogram, 0, sizeof histogram);
+
+    srand(1);
+    for (int i = 0; i < SAMPLES; i++) {
+        int32_t latency_us = measure(platform, 2 + rand() % (MAX_SLOTS - 1));
+        TEST_ASSERT_MESSAGE(latency_us >= 0, "Timer callback early");
+        histogram_add(&histogram, latency_us);
+    }
+    histogram_print(name, &histogram);
+}
+
+void test_timeout_latency()
+{
+    run(false, "Timeout");
+}
+
+void test_platform_timer_latency()
+{
+#if MBED_CONF_NANOSTACK_HAL_CRITICAL_SECTION_USABLE_FROM_INTERRUPT
+    const char *name = "platform_timer, interrupt";
+#elif MBED_CONF_NANOSTACK_HAL_TIMER_THREAD
+    const char *name = "platform_timer, timer thread";
+#else
+    const char *name = "platform_timer, event queue";
+#endif
+    platform_timer_set_cb(callback);
+    run(true, name);
+    platform_timer_disable();
+}
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(60, "default_auto");
+    ns_hal_init(NULL, HEAP_SIZE, NULL, NULL);
+    timer.start();
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Timeout latency", test_timeout_latency),
+    Case("platform_timer latency", test_platform_timer_latency),
+};
+
+Specification specification(greentea_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
@@ -45,6 +45,15 @@ using namespace utest::v1;
 #define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_SEED 0x6d626564
 #endif
 
+// Socket buffer sizes, 0 leaves the stack default
+#ifndef MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_SNDBUF
+#define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_SNDBUF 0
+#endif
+
+#ifndef MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_RCVBUF
+#define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_RCVBUF 0
+#endif
+
 #ifndef MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_DEBUG
 #define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_DEBUG false
 #endif
@@ -127,6 +136,20 @@ void generate_buffer(uint8_t **buffer, size_t *size, size_t min, size_t max) {
     TEST_ASSERT(buffer);
 }
 
+void set_buffer(TCPSocket *sock, int optname, int size) {
+    if (!size) {
+        return;
+    }
+    int err = sock->setsockopt(NSAPI_SOCKET, optname, &size, sizeof size);
+    TEST_ASSERT(err == 0 || err == NSAPI_ERROR_UNSUPPORTED);
+
+    int actual = 0;
+    unsigned actual_len = sizeof actual;
+    if (sock->getsockopt(NSAPI_SOCKET, optname, &actual, &actual_len) == 0) {
+        printf("TCP: %s %d bytes\r\n", optname == NSAPI_SNDBUF ? "sndbuf" : "rcvbuf", actual);
+    }
+}
+
 
 void test_tcp_packet_pressure() {
     generate_buffer(&buffer, &buffer_size,
@@ -145,6 +168,8 @@ void test_tcp_packet_pressure() {
 
     Timer timer;
     timer.start();
+    // Payload verified after the echo, retransmissions and headers excluded
+    size_t goodput_bytes = 0;
 
     // Tests exponentially growing sequences
     for (size_t size = MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN;
@@ -152,6 +177,9 @@ void test_tcp_packet_pressure() {
          size *= 2) {
         err = sock.open(net);
         TEST_ASSERT_EQUAL(0, err);
+        // Before connect, so the first advertised window is already sized
+        set_buffer(&sock, NSAPI_SNDBUF, MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_SNDBUF);
+        set_buffer(&sock, NSAPI_RCVBUF, MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_RCVBUF);
         err = sock.connect(tcp_addr);
         TEST_ASSERT_EQUAL(0, err);
         printf("TCP: %s:%d streaming %d bytes\r\n",
@@ -169,6 +197,7 @@ void test_tcp_packet_pressure() {
         size_t rx_count = 0;
         size_t tx_count = 0;
         size_t window = buffer_size;
+        int start_ms = timer.read_ms();
 
         while (tx_count < size || rx_count < size) {
             // Send out data
@@ -218,6 +247,11 @@ void test_tcp_packet_pressure() {
             }
         }
 
+        int stream_ms = timer.read_ms() - start_ms;
+        goodput_bytes += rx_count;
+        printf("TCP: %d bytes echoed in %dms, goodput %dB/s\r\n",
+            size, stream_ms, stream_ms ? (int)(1000.0f * size / stream_ms) : 0);
+
         err = sock.close();
         TEST_ASSERT_EQUAL(0, err);
     }
@@ -227,6 +261,7 @@ void test_tcp_packet_pressure() {
     printf("MBED: Speed: %.3fkb/s\r\n",
             8*(2*MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MAX -
             MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN) / (1000*timer.read()));
+    printf("MBED: Goodput: %.3fkb/s\r\n", 8*goodput_bytes / (1000*timer.read()));
 
     net->disconnect();
 }
@@ -7,9 +7,27 @@
 #include "cmsis_os2.h"
 #include "mbed_rtos_storage.h"
 #include <mbed_assert.h>
+#include "platform/mbed_critical.h"
 
 static uint8_t sys_irq_disable_counter;
 
+#if MBED_CONF_NANOSTACK_HAL_CRITICAL_SECTION_USABLE_FROM_INTERRUPT
+void platform_critical_init(void)
+{
+}
+
+void platform_enter_critical(void)
+{
+    core_util_critical_section_enter();
+    sys_irq_disable_counter++;
+}
+
+void platform_exit_critical(void)
+{
+    --sys_irq_disable_counter;
+    core_util_critical_section_exit();
+}
+#else
 static mbed_rtos_storage_mutex_t critical_mutex;
 static const osMutexAttr_t critical_mutex_attr = {
   .name = "nanostack_critical_mutex",
@@ -36,3 +54,4 @@ void platform_exit_critical(void)
     --sys_irq_disable_counter;
     osMutexRelease(critical_mutex_id);
 }
+#endif
@@ -12,10 +12,54 @@
 
 static Timer timer;
 static Timeout timeout;
-static EventQueue *equeue;
 static uint32_t due;
 static void (*arm_hal_callback)(void);
 
+/*
+ * The callback takes platform_enter_critical(). By default that is a mutex,
+ * so the callback is posted to the shared high priority event queue. A
+ * dedicated timer thread saves the queue hop, and when critical sections
+ * mask interrupts the callback runs straight from the Timeout interrupt.
+ */
+#if MBED_CONF_NANOSTACK_HAL_CRITICAL_SECTION_USABLE_FROM_INTERRUPT
+// Called once at boot
+void platform_timer_enable(void)
+{
+}
+
+static void timer_callback(void)
+{
+    due = 0;
+    arm_hal_callback();
+}
+#elif MBED_CONF_NANOSTACK_HAL_TIMER_THREAD
+static uint64_t timer_thread_stk[MBED_CONF_NANOSTACK_HAL_TIMER_THREAD_STACK_SIZE/8];
+static Thread timer_thread(osPriorityRealtime, sizeof timer_thread_stk,
+                           (unsigned char *) timer_thread_stk, "nanostack_timer_thread");
+
+static void timer_thread_main(void)
+{
+    for (;;) {
+        Thread::signal_wait(1);
+        arm_hal_callback();
+    }
+}
+
+// Called once at boot
+void platform_timer_enable(void)
+{
+    osStatus status = timer_thread.start(timer_thread_main);
+    MBED_ASSERT(status == osOK);
+}
+
+static void timer_callback(void)
+{
+    due = 0;
+    timer_thread.signal_set(1);
+}
+#else
+static EventQueue *equeue;
+
 // Called once at boot
 void platform_timer_enable(void)
 {
@@ -23,6 +67,13 @@ void platform_timer_enable(void)
     MBED_ASSERT(equeue != NULL);
 }
 
+static void timer_callback(void)
+{
+    due = 0;
+    equeue->call(arm_hal_callback);
+}
+#endif
+
 // Actually cancels a timer, not the opposite of enable
 void platform_timer_disable(void)
 {
@@ -35,12 +86,6 @@ void platform_timer_set_cb(void (*new_fp)(void))
     arm_hal_callback = new_fp;
 }
 
-static void timer_callback(void)
-{
-    due = 0;
-    equeue->call(arm_hal_callback);
-}
-
 // This is called from inside platform_enter_critical - IRQs can't happen
 void platform_timer_start(uint16_t slots)
 {
@@ -49,6 +94,13 @@ void platform_timer_start(uint16_t slots)
     timeout.attach_us(timer_callback, due);
 }
 
+#ifdef NS_EVENTLOOP_PROFILING
+uint32_t platform_profiling_timestamp_us(void)
+{
+    return us_ticker_read();
+}
+#endif
+
 // This is called from inside platform_enter_critical - IRQs can't happen
 uint16_t platform_timer_get_remaining_slots(void)
 {
@@ -14,19 +14,6 @@
 
 #define TRACE_GROUP "evlp"
 
-static void event_loop_thread(void *arg);
-
-static uint64_t event_thread_stk[MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_THREAD_STACK_SIZE/8];
-static mbed_rtos_storage_thread_t event_thread_tcb;
-static const osThreadAttr_t event_thread_attr = {
-    .name = "nanostack_event_thread",
-    .priority = osPriorityNormal,
-    .stack_mem = &event_thread_stk[0],
-    .stack_size = sizeof event_thread_stk,
-    .cb_mem = &event_thread_tcb,
-    .cb_size = sizeof event_thread_tcb,
-};
-static osThreadId_t event_thread_id;
 static mbed_rtos_storage_mutex_t event_mutex;
 static const osMutexAttr_t event_mutex_attr = {
   .name = "nanostack_event_mutex",
@@ -61,6 +48,28 @@ uint8_t eventOS_scheduler_mutex_is_owner(void)
     return osThreadGetId() == event_mutex_owner_id ? 1 : 0;
 }
 
+void ns_event_loop_init(void)
+{
+    event_mutex_id = osMutexNew(&event_mutex_attr);
+    MBED_ASSERT(event_mutex_id != NULL);
+}
+
+// With use_mbed_events the event loop runs on the shared event queue, see ns_event_loop_mbed_events.cpp
+#if !MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_USE_MBED_EVENTS
+static void event_loop_thread(void *arg);
+
+static uint64_t event_thread_stk[MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_THREAD_STACK_SIZE/8];
+static mbed_rtos_storage_thread_t event_thread_tcb;
+static const osThreadAttr_t event_thread_attr = {
+    .name = "nanostack_event_thread",
+    .priority = osPriorityNormal,
+    .stack_mem = &event_thread_stk[0],
+    .stack_size = sizeof event_thread_stk,
+    .cb_mem = &event_thread_tcb,
+    .cb_size = sizeof event_thread_tcb,
+};
+static osThreadId_t event_thread_id;
+
 void eventOS_scheduler_signal(void)
 {
     // XXX why does signal set lock if called with irqs disabled?
@@ -87,9 +96,6 @@ static void event_loop_thread(void *arg)
 
 void ns_event_loop_thread_create(void)
 {
-    event_mutex_id = osMutexNew(&event_mutex_attr);
-    MBED_ASSERT(event_mutex_id != NULL);
-
     event_thread_id = osThreadNew(event_loop_thread, NULL, &event_thread_attr);
     MBED_ASSERT(event_thread_id != NULL);
 }
@@ -97,3 +103,4 @@ void ns_event_loop_thread_create(void)
 void ns_event_loop_thread_start(void)
 {
 }
+#endif // !MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_USE_MBED_EVENTS
@@ -6,6 +6,7 @@
 extern "C" {
 #endif
 
+void ns_event_loop_init(void);
 void ns_event_loop_thread_create(void);
 void ns_event_loop_thread_start(void);
 
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017 ARM Limited, All Rights Reserved
+ */
+
+// Include before mbed.h to properly get UINT*_C()
+#include "ns_types.h"
+
+#include "mbed.h"
+#include "platform/mbed_critical.h"
+#include <mbed_assert.h>
+
+#include "eventOS_scheduler.h"
+
+#include "ns_event_loop.h"
+
+/*
+ * The scheduler runs on the shared mbed event queue instead of its own
+ * thread. Queueing a Nanostack event posts one dispatch call, which runs
+ * a batch of queued events with the scheduler mutex held and posts itself
+ * again if more are left, so other calls on the queue get their turn.
+ */
+#if MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_USE_MBED_EVENTS
+// Nanostack events run per dispatch call
+#define EVENT_LOOP_DISPATCH_BATCH   8
+// Delay before posting again when the queue's event buffer is full
+#define EVENT_LOOP_RETRY_US         1000
+
+static EventQueue *equeue;
+// Set while a dispatch call is posted and not started yet, or a retry waits
+static bool dispatch_posted;
+static Timeout dispatch_retry;
+
+static void event_loop_dispatch(void)
+{
+    bool more = true;
+
+    core_util_critical_section_enter();
+    dispatch_posted = false;
+    core_util_critical_section_exit();
+
+    eventOS_scheduler_mutex_wait();
+    for (uint8_t i = 0; i < EVENT_LOOP_DISPATCH_BATCH && more; i++) {
+        more = eventOS_scheduler_dispatch_event();
+    }
+    eventOS_scheduler_mutex_release();
+
+    if (more) {
+        eventOS_scheduler_signal();
+    }
+}
+
+// Interrupt context, from the retry timeout
+static void event_loop_retry(void)
+{
+    core_util_critical_section_enter();
+    dispatch_posted = false;
+    core_util_critical_section_exit();
+    eventOS_scheduler_signal();
+}
+
+// Critical section held
+static void event_loop_post(void)
+{
+    dispatch_posted = true;
+    if (equeue->call(event_loop_dispatch) == 0) {
+        // The buffer is shared with application posts, try again later
+        dispatch_retry.attach_us(event_loop_retry, EVENT_LOOP_RETRY_US);
+    }
+}
+
+// Called from interrupt too, by eventOS_deferred_post()
+void eventOS_scheduler_signal(void)
+{
+    core_util_critical_section_enter();
+    if (!dispatch_posted) {
+        // One call at a time, so the loop takes one slot of the event buffer
+        event_loop_post();
+    }
+    core_util_critical_section_exit();
+}
+
+void eventOS_scheduler_idle(void)
+{
+    // Only eventOS_scheduler_run() idles, and the queue dispatches instead
+    MBED_ASSERT(false);
+}
+
+void ns_event_loop_thread_create(void)
+{
+    equeue = mbed_event_queue();
+    MBED_ASSERT(equeue != NULL);
+}
+
+void ns_event_loop_thread_start(void)
+{
+    // Run anything queued before the queue was known
+    eventOS_scheduler_signal();
+}
+#endif // MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_USE_MBED_EVENTS
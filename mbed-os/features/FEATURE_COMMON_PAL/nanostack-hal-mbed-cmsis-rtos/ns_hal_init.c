@@ -29,6 +29,7 @@ void ns_hal_init(void *heap, size_t h_size, void (*passed_fptr)(heap_fail_t), me
         }
     }
     platform_critical_init();
+    ns_event_loop_init();
     ns_dyn_mem_init(heap, h_size, passed_fptr, info_ptr);
     platform_timer_enable();
     eventOS_scheduler_init();
@@ -84,6 +84,20 @@ typedef struct arm_event_storage {
     ns_list_link_t link;
 } arm_event_storage_t;
 
+/**
+ * \brief Usage of an event or system timer storage pool.
+ *
+ * The pool starts with its static entries and grows by slabs allocated from
+ * the heap, which are kept for reuse.
+ */
+typedef struct eventOS_pool_stats {
+    uint16_t size;          /**< Entries in the pool, static and slabs */
+    uint16_t used;          /**< Entries in use, including ones allocated individually when slab size is 0 */
+    uint16_t high_water;    /**< Most entries in use at a time */
+    uint16_t slabs;         /**< Heap allocations made to grow the pool */
+    uint16_t failures;      /**< Allocations that failed for lack of heap */
+} eventOS_pool_stats_t;
+
 /**
  * \brief Send event to event scheduler.
  *
@@ -163,6 +177,59 @@ extern int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_t
  */
 extern void eventOS_cancel(arm_event_storage_t *event);
 
+/**
+ * \brief Deferred call from interrupt to a tasklet.
+ *
+ * A caller-owned event that can be posted from interrupt context without
+ * allocating or locking, e.g. for an RF driver handing RX done over to its
+ * tasklet. Posts made before the event runs coalesce into one delivery, a
+ * post while the handler is running delivers it again after it returns.
+ * The event is queued at its priority before the next event is dispatched.
+ */
+typedef struct eventOS_deferred {
+    arm_event_storage_t event;  /**< Event delivered to the receiver, set by eventOS_deferred_init() */
+    volatile uint8_t pending;   /**< Internal, posted and not queued yet */
+    ns_list_link_t link;        /**< Internal, link in the deferred call list */
+} eventOS_deferred_t;
+
+/**
+ * \brief Initialise and register a deferred call.
+ *
+ * Not callable from interrupt. The storage must remain valid until
+ * eventOS_deferred_delete().
+ *
+ * \param deferred Caller-owned deferred call storage.
+ * \param event Event data delivered on every run, copied.
+ */
+extern void eventOS_deferred_init(eventOS_deferred_t *deferred, const arm_event_t *event);
+
+/**
+ * \brief Post a deferred call.
+ *
+ * Callable from interrupt and from any thread. Sets two flags and wakes the
+ * scheduler with eventOS_scheduler_signal().
+ *
+ * \param deferred Deferred call initialised with eventOS_deferred_init().
+ */
+extern void eventOS_deferred_post(eventOS_deferred_t *deferred);
+
+/**
+ * \brief Unregister a deferred call and cancel its queued event.
+ *
+ * Not callable from interrupt, and it must not be posted any more.
+ *
+ * \param deferred Deferred call initialised with eventOS_deferred_init().
+ */
+extern void eventOS_deferred_delete(eventOS_deferred_t *deferred);
+
+/**
+ * \brief Read usage of the event storage pool
+ *
+ * \param stats Statistics are copied here
+ *
+ * */
+extern void eventOS_event_pool_stats_get(eventOS_pool_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
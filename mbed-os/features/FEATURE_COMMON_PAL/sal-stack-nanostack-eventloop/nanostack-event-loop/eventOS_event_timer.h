@@ -195,6 +195,10 @@ extern arm_event_storage_t *eventOS_event_timer_request_every(const struct arm_e
  * Cancel an event timer
  *
  * This cancels a pending timed event, matched by event_id and tasklet_id.
+ * Pending timers are hashed by tasklet and event ID into a table that
+ * grows with the timer pool, so only the few timers sharing a bucket are
+ * compared. A timer that has already launched is looked up in the event
+ * queue.
  *
  * \param event_id event_id for event
  * \param tasklet_id receiver for event
@@ -215,6 +219,14 @@ extern int8_t eventOS_event_timer_cancel(uint8_t event_id, int8_t tasklet_id);
  * */
 extern uint32_t eventOS_event_timer_shortest_active_timer(void);
 
+/**
+ * \brief Read usage of the system timer storage pool
+ *
+ * \param stats Statistics are copied here
+ *
+ * */
+extern void eventOS_event_timer_pool_stats_get(eventOS_pool_stats_t *stats);
+
 
 /** Timeout structure. Not to be modified by user */
 typedef struct timeout_entry_t timeout_t;
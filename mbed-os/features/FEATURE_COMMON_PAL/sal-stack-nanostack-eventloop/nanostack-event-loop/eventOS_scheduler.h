@@ -71,6 +71,39 @@ int eventOS_scheduler_timer_stop(void);
  * */
 int eventOS_scheduler_timer_synch_after_sleep(uint32_t sleep_ticks);
 
+/**
+ * \brief Scheduler statistics of a tasklet.
+ *
+ * Collected only when the event loop is built with NS_EVENTLOOP_PROFILING.
+ * Times are in microseconds from platform_profiling_timestamp_us().
+ */
+typedef struct eventOS_tasklet_stats {
+    uint32_t events;            /**< Events dispatched to the tasklet */
+    uint32_t run_total_us;      /**< Total time spent in the tasklet handler */
+    uint32_t run_max_us;        /**< Longest single handler run */
+    uint32_t delayed_events;    /**< Events with known queueing delay, all but user allocated ones */
+    uint32_t delay_total_us;    /**< Total time from queueing to dispatch */
+    uint32_t delay_max_us;      /**< Longest time from queueing to dispatch */
+} eventOS_tasklet_stats_t;
+
+/**
+ * \brief Read scheduler statistics of a tasklet
+ *
+ * \param tasklet_id Tasklet ID
+ * \param stats Statistics are copied here
+ *
+ * \return 0 OK
+ * \return -1 No such tasklet, or the event loop is built without profiling
+ *
+ * */
+extern int8_t eventOS_scheduler_tasklet_stats_get(int8_t tasklet_id, eventOS_tasklet_stats_t *stats);
+
+/**
+ * \brief Clear scheduler statistics of all tasklets
+ *
+ * */
+extern void eventOS_scheduler_tasklet_stats_reset(void);
+
 /**
  * \brief Read current active Tasklet ID
  *
@@ -108,6 +141,8 @@ extern void eventOS_scheduler_wait(void);
 
 /**
  * \brief This function will be called when stack receives an event.
+ *
+ * Must be callable from interrupt context, eventOS_deferred_post() calls it.
  */
 extern void eventOS_scheduler_signal(void);
 
@@ -88,6 +88,15 @@ extern int8_t platform_tick_timer_stop(void);
 
 #endif // NS_EVENTLOOP_USE_TICK_TIMER
 
+#ifdef NS_EVENTLOOP_PROFILING
+/**
+ * \brief This function is API for the scheduler profiling timestamp
+ *
+ * \return free running microsecond count, wrapping at 32 bits
+ */
+extern uint32_t platform_profiling_timestamp_us(void);
+#endif // NS_EVENTLOOP_PROFILING
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,18 @@
 #undef NS_EVENTLOOP_USE_TICK_TIMER
 /* Exclude high resolution timer from build (removes need for "platform_timer" API) */
 #undef NS_EXCLUDE_HIGHRES_TIMER
+/* Maximum number of tasklets, size of the table indexed by tasklet ID */
+#undef NS_EVENTLOOP_TASKLET_TABLE_SIZE
+/* Arm the timer for the next system timer only instead of ticking (requires "platform_timer" API) */
+#undef NS_EVENTLOOP_TICKLESS
+/* Collect per-tasklet scheduler statistics (requires "platform_profiling_timestamp_us" API) */
+#undef NS_EVENTLOOP_PROFILING
+/* Events in the static pool, and events per slab added from the heap when it runs out (0 allocates each event) */
+#undef NS_EVENTLOOP_EVENT_POOL_SIZE
+#undef NS_EVENTLOOP_EVENT_SLAB_SIZE
+/* Same for system timers */
+#undef NS_EVENTLOOP_TIMER_POOL_SIZE
+#undef NS_EVENTLOOP_TIMER_SLAB_SIZE
 
 /*
  * mbedOS 5 specific configuration flag mapping to internal flags
@@ -39,6 +51,34 @@
 #define NS_EXCLUDE_HIGHRES_TIMER        1
 #endif
 
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_TASKLET_TABLE_SIZE
+#define NS_EVENTLOOP_TASKLET_TABLE_SIZE MBED_CONF_NANOSTACK_EVENTLOOP_TASKLET_TABLE_SIZE
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_TICKLESS
+#define NS_EVENTLOOP_TICKLESS           1
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_PROFILING
+#define NS_EVENTLOOP_PROFILING          1
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_EVENT_POOL_SIZE
+#define NS_EVENTLOOP_EVENT_POOL_SIZE    MBED_CONF_NANOSTACK_EVENTLOOP_EVENT_POOL_SIZE
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_EVENT_SLAB_SIZE
+#define NS_EVENTLOOP_EVENT_SLAB_SIZE    MBED_CONF_NANOSTACK_EVENTLOOP_EVENT_SLAB_SIZE
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_TIMER_POOL_SIZE
+#define NS_EVENTLOOP_TIMER_POOL_SIZE    MBED_CONF_NANOSTACK_EVENTLOOP_TIMER_POOL_SIZE
+#endif
+
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_TIMER_SLAB_SIZE
+#define NS_EVENTLOOP_TIMER_SLAB_SIZE    MBED_CONF_NANOSTACK_EVENTLOOP_TIMER_SLAB_SIZE
+#endif
+
 /*
  * For mbedOS 3 and minar use platform tick timer by default, highres timers should come from eventloop adaptor
  */
@@ -53,4 +93,47 @@
 #include NS_EVENTLOOP_USER_CONFIG_FILE
 #endif
 
+/*
+ * Defaults for options not set above
+ */
+#ifndef NS_EVENTLOOP_TASKLET_TABLE_SIZE
+#define NS_EVENTLOOP_TASKLET_TABLE_SIZE 32
+#endif
+
+#ifndef NS_EVENTLOOP_EVENT_POOL_SIZE
+#define NS_EVENTLOOP_EVENT_POOL_SIZE    10
+#endif
+
+#ifndef NS_EVENTLOOP_EVENT_SLAB_SIZE
+#define NS_EVENTLOOP_EVENT_SLAB_SIZE    8
+#endif
+
+#ifndef NS_EVENTLOOP_TIMER_POOL_SIZE
+#define NS_EVENTLOOP_TIMER_POOL_SIZE    6
+#endif
+
+#ifndef NS_EVENTLOOP_TIMER_SLAB_SIZE
+#define NS_EVENTLOOP_TIMER_SLAB_SIZE    4
+#endif
+
+/*
+ * Pool sizes are counted in the uint16_t fields of eventOS_pool_stats_t,
+ * and a static pool must not be empty
+ */
+#if NS_EVENTLOOP_EVENT_POOL_SIZE < 1 || NS_EVENTLOOP_EVENT_POOL_SIZE > 65535
+#error "NS_EVENTLOOP_EVENT_POOL_SIZE must be 1-65535"
+#endif
+
+#if NS_EVENTLOOP_EVENT_SLAB_SIZE < 0 || NS_EVENTLOOP_EVENT_SLAB_SIZE > 65535
+#error "NS_EVENTLOOP_EVENT_SLAB_SIZE must be 0-65535"
+#endif
+
+#if NS_EVENTLOOP_TIMER_POOL_SIZE < 1 || NS_EVENTLOOP_TIMER_POOL_SIZE > 65535
+#error "NS_EVENTLOOP_TIMER_POOL_SIZE must be 1-65535"
+#endif
+
+#if NS_EVENTLOOP_TIMER_SLAB_SIZE < 0 || NS_EVENTLOOP_TIMER_SLAB_SIZE > 65535
+#error "NS_EVENTLOOP_TIMER_SLAB_SIZE must be 0-65535"
+#endif
+
 #endif /* EVENTLOOP_CONFIG_H_ */
@@ -23,21 +23,53 @@
 #include "ns_timer.h"
 #include "event.h"
 #include "platform/arm_hal_interrupt.h"
+#include "platform/arm_hal_timer.h"
+#include "platform/eventloop_config.h"
 
+#if NS_EVENTLOOP_TASKLET_TABLE_SIZE < 1 || NS_EVENTLOOP_TASKLET_TABLE_SIZE > INT8_MAX + 1
+#error "NS_EVENTLOOP_TASKLET_TABLE_SIZE must be 1-128"
+#endif
 
 typedef struct arm_core_tasklet {
     int8_t id; /**< Event handler Tasklet ID */
     void (*func_ptr)(arm_event_s *);
-    ns_list_link_t link;
+#ifdef NS_EVENTLOOP_PROFILING
+    eventOS_tasklet_stats_t stats;
+#endif
 } arm_core_tasklet_t;
 
-static NS_LIST_DEFINE(arm_core_tasklet_list, arm_core_tasklet_t, link);
-static NS_LIST_DEFINE(event_queue_active, arm_event_storage_t, link);
+/* Events allocated here, with the time they were queued when profiling.
+ * User allocated events have no room for it. */
+typedef struct event_core_storage {
+    arm_event_storage_t event;
+#ifdef NS_EVENTLOOP_PROFILING
+    uint32_t queued_at;
+#endif
+} event_core_storage_t;
+
+/* Indexed by tasklet ID, every dispatched event looks its receiver up here */
+static arm_core_tasklet_t *arm_core_tasklet_table[NS_EVENTLOOP_TASKLET_TABLE_SIZE];
 static NS_LIST_DEFINE(free_event_entry, arm_event_storage_t, link);
 
+/* One FIFO per priority, so queueing and dequeueing with interrupts
+ * disabled does not depend on the number of queued events. */
+#define EVENT_PRIORITY_COUNT (ARM_LIB_LOW_PRIORITY_EVENT + 1)
+typedef NS_LIST_HEAD(arm_event_storage_t, link) event_queue_t;
+static event_queue_t event_queue_active[EVENT_PRIORITY_COUNT];
+/* Bit per non-empty priority */
+static uint8_t event_queue_active_mask;
+
+/* Deferred calls, checked for posts before every dispatch */
+static NS_LIST_DEFINE(event_deferred_list, eventOS_deferred_t, link);
+/* Set from interrupt when a deferred call is posted */
+static volatile uint8_t event_deferred_posted;
+
 // Statically allocate initial pool of events.
-#define STARTUP_EVENT_POOL_SIZE 10
-static arm_event_storage_t startup_event_pool[STARTUP_EVENT_POOL_SIZE];
+static event_core_storage_t startup_event_pool[NS_EVENTLOOP_EVENT_POOL_SIZE];
+/* The pool grows by slabs that are never freed. Slab events are pooled
+ * like startup pool events and use the same allocator type, the type is
+ * shared with the Nanostack library. */
+static eventOS_pool_stats_t event_pool_stats;
 
 /** Curr_tasklet tell to core and platform which task_let is active, Core Update this automatic when switch Tasklet. */
 int8_t curr_tasklet = 0;
@@ -50,12 +82,10 @@ static void event_core_write(arm_event_storage_t *event);
 
 static arm_core_tasklet_t *event_tasklet_handler_get(uint8_t tasklet_id)
 {
-    ns_list_foreach(arm_core_tasklet_t, cur, &arm_core_tasklet_list) {
-        if (cur->id == tasklet_id) {
-            return cur;
-        }
+    if (tasklet_id >= NS_EVENTLOOP_TASKLET_TABLE_SIZE) {
+        return NULL;
     }
-    return NULL;
+    return arm_core_tasklet_table[tasklet_id];
 }
 
 bool event_tasklet_handler_id_valid(uint8_t tasklet_id)
@@ -67,9 +97,8 @@ bool event_tasklet_handler_id_valid(uint8_t tasklet_id)
 // curr_tasklet is reset to 0 in various places.
 static int8_t tasklet_get_free_id(void)
 {
-    /*(Note use of uint8_t to avoid overflow if we reach 0x7F)*/
-    for (uint8_t i = 0; i <= INT8_MAX; i++) {
-        if (!event_tasklet_handler_get(i)) {
+    for (int i = 0; i < NS_EVENTLOOP_TASKLET_TABLE_SIZE; i++) {
+        if (!arm_core_tasklet_table[i]) {
             return i;
         }
     }
@@ -82,12 +111,17 @@ int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uin
     arm_event_storage_t *event_tmp;
 
     // XXX Do we really want to prevent multiple tasklets with same function?
-    ns_list_foreach(arm_core_tasklet_t, cur, &arm_core_tasklet_list) {
-        if (cur->func_ptr == handler_func_ptr) {
+    for (int i = 0; i < NS_EVENTLOOP_TASKLET_TABLE_SIZE; i++) {
+        if (arm_core_tasklet_table[i] && arm_core_tasklet_table[i]->func_ptr == handler_func_ptr) {
             return -1;
         }
     }
 
+    int8_t id = tasklet_get_free_id();
+    if (id < 0) {
+        return -2;
+    }
+
     //Allocate new
     arm_core_tasklet_t *new = tasklet_dynamically_allocate();
     if (!new) {
@@ -100,10 +134,13 @@ int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uin
         return -2;
     }
 
-    //Fill in tasklet; add to list
-    new->id = tasklet_get_free_id();
+    //Fill in tasklet; add to table
+    new->id = id;
     new->func_ptr = handler_func_ptr;
-    ns_list_add_to_end(&arm_core_tasklet_list, new);
+#ifdef NS_EVENTLOOP_PROFILING
+    memset(&new->stats, 0, sizeof new->stats);
+#endif
+    arm_core_tasklet_table[id] = new;
 
     //Queue "init" event for the new task
     event_tmp->data.receiver = new->id;
@@ -140,19 +177,50 @@ void eventOS_event_send_timer_allocated(arm_event_storage_t *event)
     event_core_write(event);
 }
 
+static uint_fast8_t event_priority_index(const arm_event_storage_t *event)
+{
+    uint_fast8_t priority = event->data.priority;
+    return priority < EVENT_PRIORITY_COUNT ? priority : ARM_LIB_LOW_PRIORITY_EVENT;
+}
+
 void eventOS_event_cancel_critical(arm_event_storage_t *event)
 {
-    ns_list_remove(&event_queue_active, event);
+    uint_fast8_t priority = event_priority_index(event);
+    ns_list_remove(&event_queue_active[priority], event);
+    if (ns_list_is_empty(&event_queue_active[priority])) {
+        event_queue_active_mask &= ~(1u << priority);
+    }
 }
 
+#if NS_EVENTLOOP_EVENT_SLAB_SIZE > 0
+/* Called in critical section, returns the first event of a new slab and puts the rest to the free list */
 static arm_event_storage_t *event_dynamically_allocate(void)
 {
-    arm_event_storage_t *event = ns_dyn_mem_temporary_alloc(sizeof(arm_event_storage_t));
-    if (event) {
-        event->allocator = ARM_LIB_EVENT_DYNAMIC;
+    event_core_storage_t *slab = ns_dyn_mem_alloc(NS_EVENTLOOP_EVENT_SLAB_SIZE * sizeof(event_core_storage_t));
+    if (!slab) {
+        return NULL;
     }
-    return event;
+    for (unsigned i = 0; i < NS_EVENTLOOP_EVENT_SLAB_SIZE; i++) {
+        slab[i].event.allocator = ARM_LIB_EVENT_STARTUP_POOL;
+        if (i > 0) {
+            ns_list_add_to_start(&free_event_entry, &slab[i].event);
+        }
+    }
+    event_pool_stats.size += NS_EVENTLOOP_EVENT_SLAB_SIZE;
+    event_pool_stats.slabs++;
+    return &slab[0].event;
+}
+#else
+static arm_event_storage_t *event_dynamically_allocate(void)
+{
+    event_core_storage_t *storage = ns_dyn_mem_temporary_alloc(sizeof(event_core_storage_t));
+    if (!storage) {
+        return NULL;
+    }
+    storage->event.allocator = ARM_LIB_EVENT_DYNAMIC;
+    return &storage->event;
 }
+#endif
 
 static arm_core_tasklet_t *tasklet_dynamically_allocate(void)
 {
@@ -172,11 +240,23 @@ arm_event_storage_t *event_core_get(void)
     if (event) {
         event->data.data_ptr = NULL;
         event->data.priority = ARM_LIB_LOW_PRIORITY_EVENT;
+        if (++event_pool_stats.used > event_pool_stats.high_water) {
+            event_pool_stats.high_water = event_pool_stats.used;
+        }
+    } else {
+        event_pool_stats.failures++;
     }
     platform_exit_critical();
     return event;
 }
 
+void eventOS_event_pool_stats_get(eventOS_pool_stats_t *stats)
+{
+    platform_enter_critical();
+    *stats = event_pool_stats;
+    platform_exit_critical();
+}
+
 void event_core_free_push(arm_event_storage_t *free)
 {
     free->state = ARM_LIB_EVENT_UNQUEUED;
@@ -185,10 +265,14 @@ void event_core_free_push(arm_event_storage_t *free)
         case ARM_LIB_EVENT_STARTUP_POOL:
             platform_enter_critical();
             ns_list_add_to_start(&free_event_entry, free);
+            event_pool_stats.used--;
             platform_exit_critical();
             break;
         case ARM_LIB_EVENT_DYNAMIC:
             // Free all dynamically allocated events.
+            platform_enter_critical();
+            event_pool_stats.used--;
+            platform_exit_critical();
             ns_dyn_mem_free(free);
             break;
         case ARM_LIB_EVENT_TIMER:
@@ -204,44 +288,186 @@ void event_core_free_push(arm_event_storage_t *free)
 
 static arm_event_storage_t *event_core_read(void)
 {
+    arm_event_storage_t *event = NULL;
     platform_enter_critical();
-    arm_event_storage_t *event = ns_list_get_first(&event_queue_active);
-    if (event) {
+    if (event_queue_active_mask) {
+        // note enum ordering means the lowest set bit is the highest priority
+        uint_fast8_t priority = 0;
+        while (!(event_queue_active_mask & (1u << priority))) {
+            priority++;
+        }
+        event = ns_list_get_first(&event_queue_active[priority]);
         event->state = ARM_LIB_EVENT_RUNNING;
-        ns_list_remove(&event_queue_active, event);
+        ns_list_remove(&event_queue_active[priority], event);
+        if (ns_list_is_empty(&event_queue_active[priority])) {
+            event_queue_active_mask &= ~(1u << priority);
+        }
     }
     platform_exit_critical();
     return event;
 }
 
-void event_core_write(arm_event_storage_t *event)
+#ifdef NS_EVENTLOOP_PROFILING
+/* Where the time an event was queued is kept, NULL for user allocated events */
+static uint32_t *event_queued_at(arm_event_storage_t *event)
+{
+    switch (event->allocator) {
+        case ARM_LIB_EVENT_STARTUP_POOL:
+        case ARM_LIB_EVENT_DYNAMIC:
+            return &NS_CONTAINER_OF(event, event_core_storage_t, event)->queued_at;
+        case ARM_LIB_EVENT_TIMER:
+            return &NS_CONTAINER_OF(event, sys_timer_struct_s, event)->queued_at;
+        case ARM_LIB_EVENT_USER:
+        default:
+            return NULL;
+    }
+}
+
+static void event_profile(arm_core_tasklet_t *tasklet, const uint32_t *queued_at, uint32_t started, uint32_t finished)
+{
+    eventOS_tasklet_stats_t *stats = &tasklet->stats;
+    uint32_t run_us = finished - started;
+
+    stats->events++;
+    stats->run_total_us += run_us;
+    if (run_us > stats->run_max_us) {
+        stats->run_max_us = run_us;
+    }
+    if (queued_at) {
+        uint32_t delay_us = started - *queued_at;
+        stats->delayed_events++;
+        stats->delay_total_us += delay_us;
+        if (delay_us > stats->delay_max_us) {
+            stats->delay_max_us = delay_us;
+        }
+    }
+}
+#endif
+
+int8_t eventOS_scheduler_tasklet_stats_get(int8_t tasklet_id, eventOS_tasklet_stats_t *stats)
 {
+#ifdef NS_EVENTLOOP_PROFILING
+    arm_core_tasklet_t *tasklet = tasklet_id >= 0 ? event_tasklet_handler_get(tasklet_id) : NULL;
+    if (!tasklet) {
+        return -1;
+    }
     platform_enter_critical();
-    bool added = false;
-    ns_list_foreach(arm_event_storage_t, event_tmp, &event_queue_active) {
-        // note enum ordering means we're checking if event_tmp is LOWER priority than event
-        if (event_tmp->data.priority > event->data.priority) {
-            ns_list_add_before(&event_queue_active, event_tmp, event);
-            added = true;
-            break;
+    *stats = tasklet->stats;
+    platform_exit_critical();
+    return 0;
+#else
+    (void)tasklet_id;
+    (void)stats;
+    return -1;
+#endif
+}
+
+void eventOS_scheduler_tasklet_stats_reset(void)
+{
+#ifdef NS_EVENTLOOP_PROFILING
+    platform_enter_critical();
+    for (int i = 0; i < NS_EVENTLOOP_TASKLET_TABLE_SIZE; i++) {
+        if (arm_core_tasklet_table[i]) {
+            memset(&arm_core_tasklet_table[i]->stats, 0, sizeof(eventOS_tasklet_stats_t));
         }
     }
-    if (!added) {
-        ns_list_add_to_end(&event_queue_active, event);
+    platform_exit_critical();
+#endif
+}
+
+// Requires lock to be held
+static void event_core_insert(arm_event_storage_t *event)
+{
+    uint_fast8_t priority = event_priority_index(event);
+#ifdef NS_EVENTLOOP_PROFILING
+    uint32_t *queued_at = event_queued_at(event);
+    if (queued_at) {
+        *queued_at = platform_profiling_timestamp_us();
     }
+#endif
+    ns_list_add_to_end(&event_queue_active[priority], event);
+    event_queue_active_mask |= 1u << priority;
     event->state = ARM_LIB_EVENT_QUEUED;
+}
+
+void event_core_write(arm_event_storage_t *event)
+{
+    platform_enter_critical();
+    event_core_insert(event);
 
     /* Wake From Idle */
     platform_exit_critical();
     eventOS_scheduler_signal();
 }
 
+void eventOS_deferred_init(eventOS_deferred_t *deferred, const arm_event_t *event)
+{
+    deferred->event.data = *event;
+    deferred->event.allocator = ARM_LIB_EVENT_USER;
+    deferred->event.state = ARM_LIB_EVENT_UNQUEUED;
+    deferred->pending = 0;
+    platform_enter_critical();
+    ns_list_add_to_end(&event_deferred_list, deferred);
+    platform_exit_critical();
+}
+
+void eventOS_deferred_delete(eventOS_deferred_t *deferred)
+{
+    platform_enter_critical();
+    ns_list_remove(&event_deferred_list, deferred);
+    if (deferred->event.state == ARM_LIB_EVENT_QUEUED) {
+        eventOS_event_cancel_critical(&deferred->event);
+        deferred->event.state = ARM_LIB_EVENT_UNQUEUED;
+    }
+    platform_exit_critical();
+}
+
+/* No lock, only single byte stores, so it can be called from interrupt */
+void eventOS_deferred_post(eventOS_deferred_t *deferred)
+{
+    if (deferred->pending) {
+        // Still to be picked up, coalesces with the earlier post
+        return;
+    }
+    deferred->pending = 1;
+    event_deferred_posted = 1;
+    eventOS_scheduler_signal();
+}
+
+/* Queues the posted deferred calls, called from the dispatching thread */
+static void event_deferred_queue(void)
+{
+    if (!event_deferred_posted) {
+        return;
+    }
+    platform_enter_critical();
+    // A post from now on is seen on the next round
+    event_deferred_posted = 0;
+    ns_list_foreach(eventOS_deferred_t, deferred, &event_deferred_list) {
+        if (!deferred->pending) {
+            continue;
+        }
+        if (deferred->event.state == ARM_LIB_EVENT_RUNNING) {
+            // Queued again on the next round, after the handler has returned
+            event_deferred_posted = 1;
+            continue;
+        }
+        deferred->pending = 0;
+        if (deferred->event.state == ARM_LIB_EVENT_UNQUEUED) {
+            event_core_insert(&deferred->event);
+        }
+    }
+    platform_exit_critical();
+}
+
 // Requires lock to be held
 arm_event_storage_t *eventOS_event_find_by_id_critical(uint8_t tasklet_id, uint8_t event_id)
 {
-    ns_list_foreach(arm_event_storage_t, cur, &event_queue_active) {
-        if (cur->data.receiver == tasklet_id && cur->data.event_id == event_id) {
-            return cur;
+    for (uint_fast8_t priority = 0; priority < EVENT_PRIORITY_COUNT; priority++) {
+        ns_list_foreach(arm_event_storage_t, cur, &event_queue_active[priority]) {
+            if (cur->data.receiver == tasklet_id && cur->data.event_id == event_id) {
+                return cur;
+            }
         }
     }
 
@@ -259,14 +485,21 @@ void eventOS_scheduler_init(void)
 {
     /* Reset Event List variables */
     ns_list_init(&free_event_entry);
-    ns_list_init(&event_queue_active);
-    ns_list_init(&arm_core_tasklet_list);
+    ns_list_init(&event_deferred_list);
+    event_deferred_posted = 0;
+    for (uint_fast8_t priority = 0; priority < EVENT_PRIORITY_COUNT; priority++) {
+        ns_list_init(&event_queue_active[priority]);
+    }
+    event_queue_active_mask = 0;
+    memset(arm_core_tasklet_table, 0, sizeof arm_core_tasklet_table);
 
-    //Add first 10 entries to "free" list
+    //Add startup pool entries to "free" list
     for (unsigned i = 0; i < (sizeof(startup_event_pool) / sizeof(startup_event_pool[0])); i++) {
-        startup_event_pool[i].allocator = ARM_LIB_EVENT_STARTUP_POOL;
-        ns_list_add_to_start(&free_event_entry, &startup_event_pool[i]);
+        startup_event_pool[i].event.allocator = ARM_LIB_EVENT_STARTUP_POOL;
+        ns_list_add_to_start(&free_event_entry, &startup_event_pool[i].event);
     }
+    memset(&event_pool_stats, 0, sizeof event_pool_stats);
+    event_pool_stats.size = NS_EVENTLOOP_EVENT_POOL_SIZE;
 
     /* Init Generic timer module */
     timer_sys_init();               //initialize timer
@@ -296,10 +529,15 @@ int eventOS_scheduler_timer_stop(void)
 
 int eventOS_scheduler_timer_synch_after_sleep(uint32_t sleep_ticks)
 {
+#ifdef NS_EVENTLOOP_TICKLESS
+    // Parameter is in milliseconds, the tickless timer keeps the remainder
+    system_timer_ms_update(sleep_ticks);
+#else
     //Update MS to 10ms ticks
     sleep_ticks /= 10;
     sleep_ticks++;
     system_timer_tick_update(sleep_ticks);
+#endif
     if (timer_sys_wakeup() == 0) {
         return 0;
     }
@@ -317,6 +555,7 @@ bool eventOS_scheduler_dispatch_event(void)
 {
     curr_tasklet = 0;
 
+    event_deferred_queue();
     arm_event_storage_t *cur_event = event_core_read();
     if (!cur_event) {
         return false;
@@ -336,7 +575,16 @@ bool eventOS_scheduler_dispatch_event(void)
      */
 
     /* Tasklet Scheduler Call */
+#ifdef NS_EVENTLOOP_PROFILING
+    // Copied, the event may be reused by the handler
+    uint32_t *queued_at = event_queued_at(cur_event);
+    uint32_t queued_at_copy = queued_at ? *queued_at : 0;
+    uint32_t started = platform_profiling_timestamp_us();
+    tasklet->func_ptr(&cur_event->data);
+    event_profile(tasklet, queued_at ? &queued_at_copy : NULL, started, platform_profiling_timestamp_us());
+#else
     tasklet->func_ptr(&cur_event->data);
+#endif
     event_core_free_push(cur_event);
 
     /* Set Current Tasklet to Idle state */
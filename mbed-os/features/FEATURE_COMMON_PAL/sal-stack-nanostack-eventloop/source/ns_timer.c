@@ -14,8 +14,8 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include "ns_types.h"
-#include "ns_list.h"
 #include "ns_timer.h"
 #include "eventOS_callback_timer.h"
 #include "platform/arm_hal_interrupt.h"
@@ -24,9 +24,8 @@
 
 #ifndef NS_EXCLUDE_HIGHRES_TIMER
 typedef enum ns_timer_state_e {
-    NS_TIMER_ACTIVE = 0,        // Will run on the next HAL interrupt
-    NS_TIMER_HOLD,              // Will run on a later HAL interrupt
-    NS_TIMER_RUN_INTERRUPT,     // Running on the interrupt we're currently handling
+    NS_TIMER_ACTIVE = 0,        // On the heap of running timers
+    NS_TIMER_RUN_INTERRUPT,     // Expired on the interrupt we're currently handling
     NS_TIMER_STOP               // Timer not scheduled ("start" not called since last callback)
 } ns_timer_state_e;
 
@@ -34,23 +33,35 @@ typedef struct ns_timer_struct {
     int8_t ns_timer_id;
     ns_timer_state_e timer_state;
     uint16_t slots;
-    uint16_t remaining_slots;
+    uint8_t heap_index;
+    uint32_t deadline;          // on the slot clock
     void (*interrupt_handler)(int8_t, uint16_t);
-    ns_list_link_t link;
+    struct ns_timer_struct *next_expired;
 } ns_timer_struct;
 
-static NS_LIST_DEFINE(ns_timer_list, ns_timer_struct, link);
+/*
+ * Registered timers are found in a table indexed by timer ID, and running
+ * timers are kept in a binary min-heap by deadline, so start and stop are
+ * O(log n) and the HAL timer is always armed for the heap top.
+ * Deadlines are absolute on a slot clock that advances with the HAL timer
+ * and stands still while it is stopped, so no per-timer remaining slots
+ * have to be recomputed and no rounding accumulates.
+ */
+#define SLOTS_BEFORE_OR_AT(a, b) ((int32_t) ((a)-(b)) <= 0)
+
+/*IDs are handed out lowest free first, so the table grows by one at most per registration*/
+static ns_timer_struct **ns_timer_table;
+static uint8_t ns_timer_table_size;
+static uint8_t ns_timer_count;
+static ns_timer_struct **ns_timer_heap;
+static uint8_t ns_timer_heap_size;
+static uint8_t ns_timer_heap_capacity;
 
 #define NS_TIMER_RUNNING    1
 static uint8_t ns_timer_state = 0;
-
-#ifdef ATMEGA256RFR2
-#define COMPENSATION 3
-#define COMPENSATION_TUNE 1
-#else
-#define COMPENSATION 0
-#define COMPENSATION_TUNE 0
-#endif
+static uint32_t ns_timer_armed_at;      // slot clock when the HAL timer was started
+static uint16_t ns_timer_armed_slots;   // slots the HAL timer was started with
+static uint32_t ns_timer_stopped_at;    // slot clock while the HAL timer is stopped
 
 static void ns_timer_interrupt_handler(void);
 static ns_timer_struct *ns_timer_get_pointer_to_timer_struct(int8_t timer_id);
@@ -84,17 +95,56 @@ int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, u
         return -1;
     }
 
+    /*Every registered timer can be running at once, so grow the heap with registrations*/
+    ns_timer_struct **new_heap = NULL;
+    if (ns_timer_heap_capacity == ns_timer_count) {
+        new_heap = ns_dyn_mem_alloc((ns_timer_heap_capacity + 1) * sizeof(ns_timer_struct *));
+        if (!new_heap) {
+            ns_dyn_mem_free(new_timer);
+            return -1;
+        }
+    }
+    ns_timer_struct **new_table = NULL;
+    if (retval == ns_timer_table_size) {
+        new_table = ns_dyn_mem_alloc((ns_timer_table_size + 1) * sizeof(ns_timer_struct *));
+        if (!new_table) {
+            ns_dyn_mem_free(new_heap);
+            ns_dyn_mem_free(new_timer);
+            return -1;
+        }
+    }
+
     /*Initialise new timer*/
     new_timer->ns_timer_id = retval;
     new_timer->timer_state = NS_TIMER_STOP;
-    new_timer->remaining_slots = 0;
     new_timer->interrupt_handler = timer_interrupt_handler;
 
-    // Critical section sufficient as long as list can't be reordered from
+    // Critical section sufficient as long as the table can't be changed from
     // interrupt, otherwise will need to cover whole routine
     platform_enter_critical();
-    ns_list_add_to_end(&ns_timer_list, new_timer);
+    ns_timer_struct **old_heap = NULL;
+    if (new_heap) {
+        old_heap = ns_timer_heap;
+        if (ns_timer_heap_size) {
+            memcpy(new_heap, ns_timer_heap, ns_timer_heap_size * sizeof(ns_timer_struct *));
+        }
+        ns_timer_heap = new_heap;
+        ns_timer_heap_capacity++;
+    }
+    ns_timer_struct **old_table = NULL;
+    if (new_table) {
+        old_table = ns_timer_table;
+        if (ns_timer_table_size) {
+            memcpy(new_table, ns_timer_table, ns_timer_table_size * sizeof(ns_timer_struct *));
+        }
+        ns_timer_table = new_table;
+        ns_timer_table_size++;
+    }
+    ns_timer_table[retval] = new_timer;
+    ns_timer_count++;
     platform_exit_critical();
+    ns_dyn_mem_free(old_heap);
+    ns_dyn_mem_free(old_table);
 
     /*Return timer ID*/
     return retval;
@@ -109,112 +159,137 @@ int8_t eventOS_callback_timer_unregister(int8_t ns_timer_id)
         return -1;
     }
 
-    // Critical section sufficient as long as list can't be reordered from
+    eventOS_callback_timer_stop(ns_timer_id);
+
+    // Critical section sufficient as long as the table can't be changed from
     // interrupt, otherwise will need to cover whole routine
     platform_enter_critical();
-    ns_list_remove(&ns_timer_list, current_timer);
+    ns_timer_table[ns_timer_id] = NULL;
+    ns_timer_count--;
     platform_exit_critical();
 
     ns_dyn_mem_free(current_timer);
     return 0;
 }
 
-
-static int8_t ns_timer_start_pl_timer(uint16_t pl_timer_start_slots)
+/* Current slot clock, called with lock held */
+static uint32_t ns_timer_now(void)
 {
-    /*Don't start timer with 0 slots*/
-    if (!pl_timer_start_slots) {
-        pl_timer_start_slots = 1;
+    if (!(ns_timer_state & NS_TIMER_RUNNING)) {
+        return ns_timer_stopped_at;
     }
-
-    /*Start HAL timer*/
-    platform_timer_start(pl_timer_start_slots);
-    /*Set HAL timer state to running*/
-    ns_timer_state |= NS_TIMER_RUNNING;
-    return 0;
+    uint16_t remaining = platform_timer_get_remaining_slots();
+    if (remaining > ns_timer_armed_slots) {
+        remaining = ns_timer_armed_slots;
+    }
+    return ns_timer_armed_at + ns_timer_armed_slots - remaining;
 }
 
-int8_t ns_timer_sleep(void)
+static void ns_timer_heap_place(ns_timer_struct *timer, uint8_t index)
 {
-    int8_t ret_val = -1;
-    if (ns_timer_state & NS_TIMER_RUNNING) {
-        /*Start HAL timer*/
-        platform_timer_disable();
-        /*Set HAL timer state to running*/
-        ns_timer_state &= ~NS_TIMER_RUNNING;
-        ret_val = 0;
-    }
-    return ret_val;
+    ns_timer_heap[index] = timer;
+    timer->heap_index = index;
 }
 
-static int8_t ns_timer_get_next_running_to(void)
+static void ns_timer_heap_up(uint8_t index)
 {
-    uint8_t hold_count = 0;
-    ns_timer_struct *first_timer = NULL;
-
-    /*Find hold-labelled timer with the least remaining slots*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->timer_state == NS_TIMER_HOLD) {
-            if (!first_timer || current_timer->remaining_slots < first_timer->remaining_slots) {
-                first_timer = current_timer;
-            }
-            /*For optimisation, count the found timers*/
-            hold_count++;
+    ns_timer_struct *timer = ns_timer_heap[index];
+    while (index > 0) {
+        uint8_t parent = (index - 1) / 2;
+        if (SLOTS_BEFORE_OR_AT(ns_timer_heap[parent]->deadline, timer->deadline)) {
+            break;
         }
+        ns_timer_heap_place(ns_timer_heap[parent], index);
+        index = parent;
     }
+    ns_timer_heap_place(timer, index);
+}
 
-    if (!first_timer) {
-        return 0;
+static void ns_timer_heap_down(uint8_t index)
+{
+    ns_timer_struct *timer = ns_timer_heap[index];
+    for (;;) {
+        uint16_t child = 2 * index + 1;
+        if (child >= ns_timer_heap_size) {
+            break;
+        }
+        if (child + 1 < ns_timer_heap_size && !SLOTS_BEFORE_OR_AT(ns_timer_heap[child]->deadline, ns_timer_heap[child + 1]->deadline)) {
+            child++;
+        }
+        if (SLOTS_BEFORE_OR_AT(timer->deadline, ns_timer_heap[child]->deadline)) {
+            break;
+        }
+        ns_timer_heap_place(ns_timer_heap[child], index);
+        index = child;
     }
+    ns_timer_heap_place(timer, index);
+}
 
-    /*If hold-labelled timer found, set it active and start the HAL driver*/
-    hold_count--;
-    first_timer->timer_state = NS_TIMER_ACTIVE;
-    /*Compensate time spent in timer function*/
-    if (first_timer->remaining_slots > COMPENSATION) {
-        first_timer->remaining_slots -= COMPENSATION;
+static void ns_timer_heap_remove(ns_timer_struct *timer)
+{
+    uint8_t index = timer->heap_index;
+    ns_timer_struct *last = ns_timer_heap[--ns_timer_heap_size];
+    if (last == timer) {
+        return;
     }
-    /*Start HAL timer*/
-    ns_timer_start_pl_timer(first_timer->remaining_slots);
+    ns_timer_heap_place(last, index);
+    ns_timer_heap_up(index);
+    ns_timer_heap_down(last->heap_index);
+}
 
-    /*Update other hold-labelled timers*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (hold_count == 0) { // early termination optimisation
-            break;
-        }
-        if (current_timer->timer_state == NS_TIMER_HOLD) {
-            if (current_timer->remaining_slots == first_timer->remaining_slots) {
-                current_timer->timer_state = NS_TIMER_ACTIVE;
-            } else {
-                current_timer->remaining_slots -= first_timer->remaining_slots;
-                /*Compensate time spent in timer function*/
-                if (current_timer->remaining_slots > COMPENSATION) {
-                    current_timer->remaining_slots -= COMPENSATION;
-                }
-            }
-            hold_count--;
+/* Arm the HAL timer for the heap top, or stop it, called with lock held */
+static void ns_timer_arm(uint32_t now)
+{
+    if (!ns_timer_heap_size) {
+        if (ns_timer_state & NS_TIMER_RUNNING) {
+            platform_timer_disable();
+            ns_timer_state &= ~NS_TIMER_RUNNING;
         }
+        ns_timer_stopped_at = now;
+        return;
     }
 
-    return 0;
+    int32_t slots = (int32_t) (ns_timer_heap[0]->deadline - now);
+    /*Don't start timer with 0 slots, an overdue timer expires one slot from now*/
+    if (slots < 1) {
+        slots = 1;
+    }
+    /*Armed from the current slot, so the slot clock never runs backwards*/
+    ns_timer_armed_at = now;
+    ns_timer_armed_slots = slots;
+    /*Start HAL timer*/
+    platform_timer_start(slots);
+    /*Set HAL timer state to running*/
+    ns_timer_state |= NS_TIMER_RUNNING;
 }
 
+int8_t ns_timer_sleep(void)
+{
+    int8_t ret_val = -1;
+    if (ns_timer_state & NS_TIMER_RUNNING) {
+        /*Slot clock stands still until a timer is started again*/
+        ns_timer_stopped_at = ns_timer_now();
+        /*Stop HAL timer*/
+        platform_timer_disable();
+        /*Set HAL timer state to stopped*/
+        ns_timer_state &= ~NS_TIMER_RUNNING;
+        ret_val = 0;
+    }
+    return ret_val;
+}
 
 static ns_timer_struct *ns_timer_get_pointer_to_timer_struct(int8_t timer_id)
 {
     /*Find timer with the given ID*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->ns_timer_id == timer_id) {
-            return current_timer;
-        }
+    if (timer_id < 0 || timer_id >= ns_timer_table_size) {
+        return NULL;
     }
-    return NULL;
+    return ns_timer_table[timer_id];
 }
 
 int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
 {
     int8_t ret_val = 0;
-    uint16_t pl_timer_remaining_slots;
     ns_timer_struct *timer;
     platform_enter_critical();
 
@@ -225,95 +300,78 @@ int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
         goto exit;
     }
 
-    // XXX this assumes the timer currently isn't running?
-    // Is event.c relying on this restarting HAL timer after ns_timer_sleep()?
+    uint32_t now = ns_timer_now();
+    bool was_first = ns_timer_heap_size && ns_timer_heap[0] == timer;
 
-    /*If any timers are active*/
-    if (ns_timer_state & NS_TIMER_RUNNING) {
-        /*Get remaining slots of the currently activated timeout*/
-        pl_timer_remaining_slots = platform_timer_get_remaining_slots();
-
-        /*New timeout is shorter than currently enabled timeout*/
-        if (pl_timer_remaining_slots > slots) {
-            /*Start HAL timer*/
-            ns_timer_start_pl_timer(slots - 0);
-
-            ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-                /*Switch active timers to hold*/
-                if (current_timer->timer_state == NS_TIMER_ACTIVE) {
-                    current_timer->timer_state = NS_TIMER_HOLD;
-                    current_timer->remaining_slots = 0;
-                }
-                /*Update hold-labelled timers*/
-                if (current_timer->timer_state == NS_TIMER_HOLD) {
-                    current_timer->remaining_slots += (pl_timer_remaining_slots - slots);
-                    /*Compensate time spent in timer function*/
-                    if (current_timer->remaining_slots > (COMPENSATION - COMPENSATION_TUNE)) {
-                        current_timer->remaining_slots -= (COMPENSATION - COMPENSATION_TUNE);
-                    }
-                }
-            }
-            /*Mark active and start the timer*/
-            timer->timer_state = NS_TIMER_ACTIVE;
-            timer->slots = slots;
-            timer->remaining_slots = slots;
-        }
-
-        /*New timeout is longer than currently enabled timeout*/
-        else if (pl_timer_remaining_slots < slots) {
-            /*Mark hold and update remaining slots*/
-            timer->timer_state = NS_TIMER_HOLD;
-            timer->slots = slots;
-            timer->remaining_slots = (slots - pl_timer_remaining_slots);
-        }
-        /*New timeout is equal to currently enabled timeout*/
-        else {
-            /*Mark it active and it will be handled in next interrupt*/
-            timer->timer_state = NS_TIMER_ACTIVE;
-            timer->slots = slots;
-            timer->remaining_slots = slots;
-        }
+    /*Restarting a running timer moves it*/
+    timer->deadline = now + slots;
+    timer->slots = slots;
+    if (timer->timer_state == NS_TIMER_ACTIVE) {
+        ns_timer_heap_up(timer->heap_index);
+        ns_timer_heap_down(timer->heap_index);
     } else {
-        /*No timers running*/
-        timer->timer_state = NS_TIMER_HOLD;
-        timer->slots = slots;
-        timer->remaining_slots = slots;
-        /*Start next timeout*/
-        ns_timer_get_next_running_to();
+        timer->timer_state = NS_TIMER_ACTIVE;
+        ns_timer_heap_place(timer, ns_timer_heap_size++);
+        ns_timer_heap_up(timer->heap_index);
+    }
+
+    /*Rearm if the heap top changed, or after ns_timer_sleep()*/
+    if (was_first || ns_timer_heap[0] == timer || !(ns_timer_state & NS_TIMER_RUNNING)) {
+        ns_timer_arm(now);
     }
 exit:
     platform_exit_critical();
     return ret_val;
 }
 
+uint16_t ns_timer_get_remaining_slots(int8_t ns_timer_id)
+{
+    uint16_t remaining = 0;
+
+    platform_enter_critical();
+    ns_timer_struct *timer = ns_timer_get_pointer_to_timer_struct(ns_timer_id);
+    if (timer && timer->timer_state == NS_TIMER_ACTIVE) {
+        int32_t slots = (int32_t) (timer->deadline - ns_timer_now());
+        remaining = slots > 0 ? slots : 0;
+    }
+    platform_exit_critical();
+    return remaining;
+}
+
 static void ns_timer_interrupt_handler(void)
 {
-    uint8_t i = 0;
+    ns_timer_struct *expired = NULL;
+    ns_timer_struct **expired_tail = &expired;
 
     platform_enter_critical();
-    /*Clear timer running state*/
+    /*Ignore an interrupt that was already on its way when the HAL timer was restarted or stopped*/
+    if (!(ns_timer_state & NS_TIMER_RUNNING) || platform_timer_get_remaining_slots()) {
+        platform_exit_critical();
+        return;
+    }
+    /*HAL timer ran to the end, so the slot clock is exactly at its deadline*/
+    uint32_t now = ns_timer_armed_at + ns_timer_armed_slots;
     ns_timer_state &= ~NS_TIMER_RUNNING;
-    /*Mark active timers as NS_TIMER_RUN_INTERRUPT, interrupt functions are called at the end of this function*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->timer_state == NS_TIMER_ACTIVE) {
-            current_timer->timer_state = NS_TIMER_RUN_INTERRUPT;
-            /*For optimisation, count the found timers*/
-            i++;
-        }
+
+    /*Take expired timers off the heap in deadline order, callbacks are called at the end of this function*/
+    while (ns_timer_heap_size && SLOTS_BEFORE_OR_AT(ns_timer_heap[0]->deadline, now)) {
+        ns_timer_struct *timer = ns_timer_heap[0];
+        ns_timer_heap_remove(timer);
+        timer->timer_state = NS_TIMER_RUN_INTERRUPT;
+        timer->next_expired = NULL;
+        *expired_tail = timer;
+        expired_tail = &timer->next_expired;
     }
 
     /*Start next timeout*/
-    ns_timer_get_next_running_to();
+    ns_timer_arm(now);
 
     /*Call interrupt functions*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (i == 0) {
-            break;
-        }
-        if (current_timer->timer_state == NS_TIMER_RUN_INTERRUPT) {
-            current_timer->timer_state = NS_TIMER_STOP;
-            current_timer->interrupt_handler(current_timer->ns_timer_id, current_timer->slots);
-            i--;
+    for (ns_timer_struct *timer = expired; timer; timer = timer->next_expired) {
+        /*Skip timers stopped or restarted by an earlier callback*/
+        if (timer->timer_state == NS_TIMER_RUN_INTERRUPT) {
+            timer->timer_state = NS_TIMER_STOP;
+            timer->interrupt_handler(timer->ns_timer_id, timer->slots);
         }
     }
 
@@ -322,10 +380,7 @@ static void ns_timer_interrupt_handler(void)
 
 int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
 {
-    uint16_t pl_timer_remaining_slots;
-    bool active_timer_found = false;
     ns_timer_struct *current_timer;
-    ns_timer_struct *first_timer = NULL;
     int8_t retval = -1;
 
     platform_enter_critical();
@@ -338,49 +393,17 @@ int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
     retval = 0;
 
     /*Check if already stopped*/
-    if (current_timer->timer_state == NS_TIMER_STOP) {
+    if (current_timer->timer_state != NS_TIMER_ACTIVE) {
+        current_timer->timer_state = NS_TIMER_STOP;
         goto exit;
     }
 
     current_timer->timer_state = NS_TIMER_STOP;
-    current_timer->remaining_slots = 0;
-
-    /*Check if some timer is already active*/
-    ns_list_foreach(ns_timer_struct, curr_timer, &ns_timer_list) {
-        if (curr_timer->timer_state == NS_TIMER_ACTIVE) {
-            active_timer_found = true;
-            break;
-        }
-    }
-    /*If no active timers found, start one*/
-    if (!active_timer_found) {
-        pl_timer_remaining_slots = platform_timer_get_remaining_slots();
-        /*Find hold-labelled timer with the least remaining slots*/
-        ns_list_foreach(ns_timer_struct, cur_timer, &ns_timer_list) {
-            if (cur_timer->timer_state == NS_TIMER_HOLD) {
-                cur_timer->remaining_slots += pl_timer_remaining_slots;
-
-                if (!first_timer || cur_timer->remaining_slots < first_timer->remaining_slots) {
-                    first_timer = cur_timer;
-                }
-            }
-        }
-        /*If hold-labelled timer found, set it active and start the HAL driver*/
-        if (first_timer) {
-            first_timer->timer_state = NS_TIMER_ACTIVE;
-            /*Start HAL timer*/
-            ns_timer_start_pl_timer(first_timer->remaining_slots);
-            /*If some of the other hold-labelled timers have the same remaining slots as the timer_tmp, mark them active*/
-            ns_list_foreach(ns_timer_struct, cur_timer, &ns_timer_list) {
-                if (cur_timer->timer_state == NS_TIMER_HOLD) {
-                    if (cur_timer->remaining_slots == first_timer->remaining_slots) {
-                        cur_timer->timer_state = NS_TIMER_ACTIVE;
-                    } else {
-                        cur_timer->remaining_slots -= first_timer->remaining_slots;
-                    }
-                }
-            }
-        }
+    bool was_first = ns_timer_heap[0] == current_timer;
+    ns_timer_heap_remove(current_timer);
+    /*Rearm for the new heap top*/
+    if (was_first && (ns_timer_state & NS_TIMER_RUNNING)) {
+        ns_timer_arm(ns_timer_now());
     }
 
 exit:
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <string.h>
 #include "ns_types.h"
 #include "ns_list.h"
 #include "timer_sys.h"
@@ -27,10 +28,12 @@
 #include "ns_timer.h"
 
 #ifndef ST_MAX
-#define ST_MAX 6
+#define ST_MAX NS_EVENTLOOP_TIMER_POOL_SIZE
 #endif
 
 static sys_timer_struct_s startup_sys_timer_pool[ST_MAX];
+/* Timers allocated from the heap, one by one or in slabs, are never freed */
+static eventOS_pool_stats_t system_timer_pool_stats;
 
 #define TIMER_SLOTS_PER_MS          20
 NS_STATIC_ASSERT(1000 % EVENTOS_EVENT_TIMER_HZ == 0, "Need whole number of ms per tick")
@@ -41,14 +44,187 @@ NS_STATIC_ASSERT(1000 % EVENTOS_EVENT_TIMER_HZ == 0, "Need whole number of ms pe
 static volatile uint32_t timer_sys_ticks;
 
 static NS_LIST_DEFINE(system_timer_free, sys_timer_struct_s, event.link);
-static NS_LIST_DEFINE(system_timer_list, sys_timer_struct_s, event.link);
+
+/*
+ * Pending timers are kept in a hierarchical timing wheel. A slot of level
+ * L spans TIMER_WHEEL_SLOTS^L ticks, and a timer sits on the lowest level
+ * whose current rotation (the slot of level L+1 the tick count is in)
+ * contains its launch time. So all timers of level L launch before those
+ * of level L+1, and slot order within a level is launch order. When the
+ * tick count enters an occupied slot of level L > 0, its timers move down
+ * to lower levels. Timers beyond the top level wait on the overflow list,
+ * which is looked at whenever the top level starts a new rotation.
+ *
+ * Insert and cancel are O(1). Advancing the tick count only stops at
+ * occupied slots, so a jump over many ticks after sleep is cheap too.
+ *
+ * Pending timers are also hashed by receiver tasklet and event ID, so
+ * eventOS_event_timer_cancel() only looks at the timers of one bucket
+ * instead of every pending timer.
+ */
+#ifndef TIMER_WHEEL_BITS
+#define TIMER_WHEEL_BITS            5
+#endif
+#ifndef TIMER_WHEEL_LEVELS
+#define TIMER_WHEEL_LEVELS          4
+#endif
+#define TIMER_WHEEL_SLOTS           (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK            (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_OVERFLOW        0xFF
+NS_STATIC_ASSERT(TIMER_WHEEL_BITS <= 5, "Slot bitmap is 32 bits")
+NS_STATIC_ASSERT(TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS < 32, "Wheel must span less than the tick counter")
+NS_STATIC_ASSERT(TIMER_WHEEL_SLOTS * TIMER_WHEEL_LEVELS < TIMER_WHEEL_OVERFLOW, "Slot index must fit wheel_slot")
+
+typedef NS_LIST_HEAD(sys_timer_struct_s, event.link) timer_wheel_slot_t;
+
+static timer_wheel_slot_t system_timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+// Bit per non-empty slot
+static uint32_t system_timer_wheel_used[TIMER_WHEEL_LEVELS];
+static timer_wheel_slot_t system_timer_overflow;
+
+/*
+ * Pending timers are also indexed by receiver tasklet and event ID, for
+ * eventOS_event_timer_cancel(). The index has a bucket per timer of the
+ * pool, and doubles when the pool outgrows it, as long as the table fits
+ * one heap block and has fewer buckets than ID pairs. Doubling splits bucket b into b and b + old size, and the buckets
+ * of the old table are moved a few at a time by later index operations,
+ * so interrupts are never held off for a rehash of every timer.
+ */
+#define TIMER_INDEX_KEYS            (128u * 256u)   // receiver 0 to 127, event ID 0 to 255
+#define TIMER_INDEX_MOVE_BUCKETS    2               // old buckets moved per index operation
+
+typedef NS_LIST_HEAD(sys_timer_struct_s, index_link) timer_index_bucket_t;
+
+static timer_index_bucket_t startup_timer_index[ST_MAX];
+static timer_index_bucket_t *system_timer_index = startup_timer_index;
+static uint32_t system_timer_index_size = ST_MAX;
+// Table being split into system_timer_index, its buckets below system_timer_index_moved are empty
+static timer_index_bucket_t *system_timer_index_old;
+static uint32_t system_timer_index_moved;
 
 
 static sys_timer_struct_s *sys_timer_dynamically_allocate(void);
-static void timer_sys_interrupt(void);
 static void timer_sys_add(sys_timer_struct_s *timer);
+static void timer_sys_remove(sys_timer_struct_s *timer);
+static sys_timer_struct_s *timer_sys_first(void);
+static void timer_sys_advance(uint32_t ticks);
+
+#ifdef NS_EVENTLOOP_TICKLESS
+#if defined NS_EVENTLOOP_USE_TICK_TIMER || defined NS_EXCLUDE_HIGHRES_TIMER
+#error "Tickless event loop needs the high resolution timer"
+#endif
+/*
+ * The callback timer is armed for the next timer launch instead of every
+ * tick, for at most TICKLESS_MAX_TICKS as it counts 16-bit slots.
+ * timer_sys_ticks is brought up to date from the slots the armed timer
+ * has run whenever it is read, and the part of a tick left over when the
+ * timer is rearmed or stopped is carried over so no time is lost.
+ */
+#define TIMER_SLOTS_PER_TICK        (TIMER_SLOTS_PER_MS * TIMER_SYS_TICK_PERIOD)
+#define TICKLESS_MAX_TICKS          (UINT16_MAX / TIMER_SLOTS_PER_TICK)
+
+static int8_t tickless_timer_id = -1;
+static bool tickless_enabled;
+static bool tickless_armed;
+static uint32_t tickless_deadline;          // tick the timer is armed for
+static uint16_t tickless_armed_slots;       // slots the timer was armed with
+static uint16_t tickless_residue;           // slots of a partial tick at arming
+static uint16_t tickless_counted_ticks;     // ticks counted since arming
+
+static uint16_t tickless_elapsed_slots(void)
+{
+    uint16_t remaining = ns_timer_get_remaining_slots(tickless_timer_id);
+    return remaining < tickless_armed_slots ? tickless_armed_slots - remaining : 0;
+}
+
+/* Count the whole ticks the armed timer has run, lock held */
+static void tickless_count(uint16_t elapsed_slots)
+{
+    uint16_t ticks = (tickless_residue + (uint32_t) elapsed_slots) / TIMER_SLOTS_PER_TICK;
+    if (ticks > tickless_counted_ticks) {
+        // Counted first, launching timers may read the ticks again
+        uint16_t advance = ticks - tickless_counted_ticks;
+        tickless_counted_ticks = ticks;
+        timer_sys_advance(advance);
+    }
+}
 
-#ifndef NS_EVENTLOOP_USE_TICK_TIMER
+/* Stop the armed timer, keeping the partial tick, lock held */
+static void tickless_disarm(void)
+{
+    if (!tickless_armed) {
+        return;
+    }
+    uint16_t elapsed = tickless_elapsed_slots();
+    tickless_count(elapsed);
+    tickless_residue = (tickless_residue + (uint32_t) elapsed) % TIMER_SLOTS_PER_TICK;
+    tickless_armed = false;
+    eventOS_callback_timer_stop(tickless_timer_id);
+}
+
+/* Arm the timer for the first pending timer, lock held */
+static void tickless_arm(void)
+{
+    tickless_disarm();
+
+    uint32_t ticks = TICKLESS_MAX_TICKS;
+    sys_timer_struct_s *first = timer_sys_first();
+    if (first && TICKS_BEFORE(first->launch_time, timer_sys_ticks + ticks)) {
+        // Pending timers are always in the future
+        ticks = first->launch_time - timer_sys_ticks;
+    }
+    tickless_deadline = timer_sys_ticks + ticks;
+    tickless_armed_slots = ticks * TIMER_SLOTS_PER_TICK - tickless_residue;
+    tickless_counted_ticks = 0;
+    tickless_armed = true;
+    eventOS_callback_timer_start(tickless_timer_id, tickless_armed_slots);
+}
+
+static void tickless_timer_callback(int8_t timer_id, uint16_t slots)
+{
+    (void)slots;
+    platform_enter_critical();
+    if (timer_id == tickless_timer_id && tickless_armed) {
+        // Ran to the deadline, which is a whole number of ticks
+        tickless_count(tickless_armed_slots);
+        tickless_residue = 0;
+        tickless_armed = false;
+        tickless_arm();
+    }
+    platform_exit_critical();
+}
+
+/* Bring timer_sys_ticks up to date, lock held */
+static void tickless_ticks_update(void)
+{
+    if (tickless_armed) {
+        tickless_count(tickless_elapsed_slots());
+    }
+}
+
+/* Rearm if a timer was added before the armed deadline, lock held */
+static void tickless_timer_added(const sys_timer_struct_s *timer)
+{
+    if (tickless_enabled && TICKS_BEFORE(timer->launch_time, tickless_deadline)) {
+        tickless_arm();
+    }
+}
+
+void system_timer_ms_update(uint32_t ms)
+{
+    platform_enter_critical();
+    uint32_t slots = tickless_residue + ms * TIMER_SLOTS_PER_MS;
+    timer_sys_advance(slots / TIMER_SLOTS_PER_TICK);
+    tickless_residue = slots % TIMER_SLOTS_PER_TICK;
+    platform_exit_critical();
+}
+#else
+#define tickless_ticks_update() ((void) 0)
+#define tickless_timer_added(timer) ((void) 0)
+static void timer_sys_interrupt(void);
+#endif // NS_EVENTLOOP_TICKLESS
+
+#if !defined NS_EVENTLOOP_USE_TICK_TIMER && !defined NS_EVENTLOOP_TICKLESS
 static int8_t platform_tick_timer_start(uint32_t period_ms);
 /* Implement platform tick timer using eventOS timer */
 // platform tick timer callback function
@@ -83,24 +259,68 @@ static int8_t platform_tick_timer_stop(void)
 {
     return eventOS_callback_timer_stop(tick_timer_id);
 }
-#endif // !NS_EVENTLOOP_USE_TICK_TIMER
+#endif // !NS_EVENTLOOP_USE_TICK_TIMER && !NS_EVENTLOOP_TICKLESS
 
 /*
  * Initializes timers and starts system timer
  */
 void timer_sys_init(void)
 {
-    for (uint8_t i = 0; i < ST_MAX; i++) {
+    for (uint16_t i = 0; i < ST_MAX; i++) {
         ns_list_add_to_start(&system_timer_free, &startup_sys_timer_pool[i]);
     }
-
+    memset(&system_timer_pool_stats, 0, sizeof system_timer_pool_stats);
+    system_timer_pool_stats.size = ST_MAX;
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            ns_list_init(&system_timer_wheel[level][slot]);
+        }
+        system_timer_wheel_used[level] = 0;
+    }
+    ns_list_init(&system_timer_overflow);
+    for (uint32_t bucket = 0; bucket < ST_MAX; bucket++) {
+        ns_list_init(&startup_timer_index[bucket]);
+    }
+    system_timer_index = startup_timer_index;
+    system_timer_index_size = ST_MAX;
+    system_timer_index_old = NULL;
+
+#ifdef NS_EVENTLOOP_TICKLESS
+    tickless_timer_id = eventOS_callback_timer_register(tickless_timer_callback);
+    timer_sys_wakeup();
+#else
     platform_tick_timer_register(timer_sys_interrupt);
     platform_tick_timer_start(TIMER_SYS_TICK_PERIOD);
+#endif
 }
 
 
 
 /*-------------------SYSTEM TIMER FUNCTIONS--------------------------*/
+#ifdef NS_EVENTLOOP_TICKLESS
+void timer_sys_disable(void)
+{
+    platform_enter_critical();
+    tickless_enabled = false;
+    tickless_disarm();
+    platform_exit_critical();
+}
+
+/*
+ * Arms the timer for the next system timer launch
+ */
+int8_t timer_sys_wakeup(void)
+{
+    if (tickless_timer_id < 0) {
+        return -1;
+    }
+    platform_enter_critical();
+    tickless_enabled = true;
+    tickless_arm();
+    platform_exit_critical();
+    return 0;
+}
+#else
 void timer_sys_disable(void)
 {
     platform_tick_timer_stop();
@@ -119,15 +339,40 @@ static void timer_sys_interrupt(void)
 {
     system_timer_tick_update(1);
 }
+#endif // NS_EVENTLOOP_TICKLESS
 
 
 
 /* * * * * * * * * */
 
+#if NS_EVENTLOOP_TIMER_SLAB_SIZE > 0
+/* Called in critical section, returns the first timer of a new slab and puts the rest to the free list */
 static sys_timer_struct_s *sys_timer_dynamically_allocate(void)
 {
-    return ns_dyn_mem_alloc(sizeof(sys_timer_struct_s));
+    sys_timer_struct_s *slab = ns_dyn_mem_alloc(NS_EVENTLOOP_TIMER_SLAB_SIZE * sizeof(sys_timer_struct_s));
+    if (!slab) {
+        return NULL;
+    }
+    for (unsigned i = 1; i < NS_EVENTLOOP_TIMER_SLAB_SIZE; i++) {
+        ns_list_add_to_start(&system_timer_free, &slab[i]);
+    }
+    system_timer_pool_stats.size += NS_EVENTLOOP_TIMER_SLAB_SIZE;
+    system_timer_pool_stats.slabs++;
+    return &slab[0];
+}
+#else
+static sys_timer_struct_s *sys_timer_dynamically_allocate(void)
+{
+    sys_timer_struct_s *timer = ns_dyn_mem_alloc(sizeof(sys_timer_struct_s));
+    if (timer) {
+        system_timer_pool_stats.size++;
+        system_timer_pool_stats.slabs++;
+    }
+    return timer;
 }
+#endif
+
+static void timer_index_grow(void);
 
 static sys_timer_struct_s *timer_struct_get(void)
 {
@@ -138,18 +383,35 @@ static sys_timer_struct_s *timer_struct_get(void)
         ns_list_remove(&system_timer_free, timer);
     } else {
         timer = sys_timer_dynamically_allocate();
+        timer_index_grow();
+    }
+    if (timer) {
+        if (++system_timer_pool_stats.used > system_timer_pool_stats.high_water) {
+            system_timer_pool_stats.high_water = system_timer_pool_stats.used;
+        }
+    } else {
+        system_timer_pool_stats.failures++;
     }
     platform_exit_critical();
     return timer;
 }
 
+void eventOS_event_timer_pool_stats_get(eventOS_pool_stats_t *stats)
+{
+    platform_enter_critical();
+    *stats = system_timer_pool_stats;
+    platform_exit_critical();
+}
+
 void timer_sys_event_free(arm_event_storage_t *event)
 {
     platform_enter_critical();
+    tickless_ticks_update();
     sys_timer_struct_s *timer = NS_CONTAINER_OF(event, sys_timer_struct_s, event);
     if (timer->period == 0) {
         // Non-periodic - return to free list
         ns_list_add_to_start(&system_timer_free, timer);
+        system_timer_pool_stats.used--;
     } else {
         // Periodic - check due time of next launch
         timer->launch_time += timer->period;
@@ -159,6 +421,7 @@ void timer_sys_event_free(arm_event_storage_t *event)
         } else {
             // add back to timer queue for the future
             timer_sys_add(timer);
+            tickless_timer_added(timer);
         }
     }
     platform_exit_critical();
@@ -168,9 +431,9 @@ void timer_sys_event_cancel_critical(struct arm_event_storage *event)
 {
     sys_timer_struct_s *timer = NS_CONTAINER_OF(event, sys_timer_struct_s, event);
     timer->period = 0;
-    // If its unqueued it is on my timer list, otherwise it is in event-loop.
+    // If its unqueued it is on my timer wheel, otherwise it is in event-loop.
     if (event->state == ARM_LIB_EVENT_UNQUEUED) {
-        ns_list_remove(&system_timer_list, timer);
+        timer_sys_remove(timer);
     }
 }
 
@@ -180,27 +443,254 @@ uint32_t eventOS_event_timer_ticks(void)
     // Enter/exit critical is a bit clunky, but necessary on 16-bit platforms,
     // which won't be able to do an atomic 32-bit read.
     platform_enter_critical();
+    tickless_ticks_update();
     ret_val = timer_sys_ticks;
     platform_exit_critical();
     return ret_val;
 }
 
-/* Called internally with lock held */
+/* Lowest set bit of a non-zero slot bitmap */
+static uint8_t timer_wheel_first_slot(uint32_t used)
+{
+    static const uint8_t debruijn_index[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    return debruijn_index[((used & -used) * UINT32_C(0x077CB531)) >> 27];
+}
+
+/* Level for a launch time after timer_sys_ticks, TIMER_WHEEL_LEVELS for overflow */
+static uint8_t timer_wheel_level(uint32_t at)
+{
+    uint32_t diff = at ^ timer_sys_ticks;
+    uint8_t level;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        diff >>= TIMER_WHEEL_BITS;
+        if (diff == 0) {
+            break;
+        }
+    }
+    return level;
+}
+
+static uint32_t timer_index_hash(int8_t tasklet_id, uint8_t event_id)
+{
+    uint32_t key = ((uint32_t) (uint8_t) tasklet_id << 8) | event_id;
+    // Spread the ID pairs over the 16 high bits, for any table size
+    return (key * UINT32_C(2654435761)) >> 16;
+}
+
+/* Index bucket of a receiver tasklet and event ID, lock held */
+static timer_index_bucket_t *timer_index_bucket(int8_t tasklet_id, uint8_t event_id)
+{
+    uint32_t hash = timer_index_hash(tasklet_id, event_id);
+    if (system_timer_index_old) {
+        uint32_t bucket = hash % (system_timer_index_size / 2);
+        if (bucket >= system_timer_index_moved) {
+            return &system_timer_index_old[bucket];
+        }
+    }
+    return &system_timer_index[hash % system_timer_index_size];
+}
+
+/* Move a few buckets of the old table to the new one, lock held */
+static void timer_index_move(void)
+{
+    uint32_t old_size = system_timer_index_size / 2;
+
+    for (uint8_t i = 0; i < TIMER_INDEX_MOVE_BUCKETS && system_timer_index_moved < old_size; i++) {
+        timer_index_bucket_t *old = &system_timer_index_old[system_timer_index_moved++];
+        ns_list_foreach_safe(sys_timer_struct_s, cur, old) {
+            ns_list_remove(old, cur);
+            uint32_t hash = timer_index_hash(cur->event.data.receiver, cur->event.data.event_id);
+            ns_list_add_to_end(&system_timer_index[hash % system_timer_index_size], cur);
+        }
+    }
+    if (system_timer_index_moved == old_size) {
+        if (system_timer_index_old != startup_timer_index) {
+            ns_dyn_mem_free(system_timer_index_old);
+        }
+        system_timer_index_old = NULL;
+    }
+}
+
+/* Double the index if the pool has outgrown it, lock held */
+static void timer_index_grow(void)
+{
+    uint32_t size = system_timer_index_size * 2;
+    if (system_timer_index_old || system_timer_pool_stats.size <= system_timer_index_size ||
+            system_timer_index_size >= TIMER_INDEX_KEYS ||
+            size > (ns_mem_block_size_t) -1 / sizeof(timer_index_bucket_t)) {
+        return;
+    }
+    timer_index_bucket_t *index = ns_dyn_mem_alloc(size * sizeof(timer_index_bucket_t));
+    if (!index) {
+        // Keep the index, cancel just gets slower
+        return;
+    }
+    for (uint32_t bucket = 0; bucket < size; bucket++) {
+        ns_list_init(&index[bucket]);
+    }
+    system_timer_index_old = system_timer_index;
+    system_timer_index_moved = 0;
+    system_timer_index = index;
+    system_timer_index_size = size;
+}
+
+/* Place a timer on the wheel by its launch time, lock held */
+static void timer_wheel_add(sys_timer_struct_s *timer)
+{
+    uint8_t level = timer_wheel_level(timer->launch_time);
+
+    if (level == TIMER_WHEEL_LEVELS) {
+        timer->wheel_slot = TIMER_WHEEL_OVERFLOW;
+        ns_list_add_to_end(&system_timer_overflow, timer);
+        return;
+    }
+
+    uint8_t slot = (timer->launch_time >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+    timer->wheel_slot = level * TIMER_WHEEL_SLOTS + slot;
+    // Timers launching on the same tick run in the order they reach level 0
+    ns_list_add_to_end(&system_timer_wheel[level][slot], timer);
+    system_timer_wheel_used[level] |= UINT32_C(1) << slot;
+}
+
+/* Take a timer off the wheel, lock held */
+static void timer_wheel_remove(sys_timer_struct_s *timer)
+{
+    if (timer->wheel_slot == TIMER_WHEEL_OVERFLOW) {
+        ns_list_remove(&system_timer_overflow, timer);
+        return;
+    }
+
+    uint8_t level = timer->wheel_slot / TIMER_WHEEL_SLOTS;
+    uint8_t slot = timer->wheel_slot & TIMER_WHEEL_MASK;
+    ns_list_remove(&system_timer_wheel[level][slot], timer);
+    if (ns_list_is_empty(&system_timer_wheel[level][slot])) {
+        system_timer_wheel_used[level] &= ~(UINT32_C(1) << slot);
+    }
+}
+
+/* Called internally with lock held, launch time must be in the future */
 static void timer_sys_add(sys_timer_struct_s *timer)
 {
-    uint32_t at = timer->launch_time;
+    if (system_timer_index_old) {
+        timer_index_move();
+    }
+    timer_wheel_add(timer);
+    ns_list_add_to_end(timer_index_bucket(timer->event.data.receiver, timer->event.data.event_id), timer);
+}
+
+/* Called internally with lock held */
+static void timer_sys_remove(sys_timer_struct_s *timer)
+{
+    if (system_timer_index_old) {
+        timer_index_move();
+    }
+    timer_wheel_remove(timer);
+    ns_list_remove(timer_index_bucket(timer->event.data.receiver, timer->event.data.event_id), timer);
+}
 
-    // Find first timer scheduled to run after us, and insert before it.
-    // (This means timers scheduled for same time run in order of request)
-    ns_list_foreach(sys_timer_struct_s, t, &system_timer_list) {
-        if (TICKS_BEFORE(at, t->launch_time)) {
-            ns_list_add_before(&system_timer_list, t, timer);
-            return;
+/* Launch due timers of a list, and move the others to where they now belong */
+static void timer_wheel_redistribute(timer_wheel_slot_t *list)
+{
+    ns_list_foreach_safe(sys_timer_struct_s, cur, list) {
+        if (TICKS_BEFORE_OR_AT(cur->launch_time, timer_sys_ticks)) {
+            ns_list_remove(list, cur);
+            ns_list_remove(timer_index_bucket(cur->event.data.receiver, cur->event.data.event_id), cur);
+            // Make it an event (can't fail - no allocation)
+            // event system will call our timer_sys_event_free on event delivery.
+            eventOS_event_send_timer_allocated(&cur->event);
+        } else if (list == &system_timer_overflow && timer_wheel_level(cur->launch_time) == TIMER_WHEEL_LEVELS) {
+            // Still beyond the top level
+            continue;
+        } else {
+            ns_list_remove(list, cur);
+            timer_wheel_add(cur);
         }
     }
+}
+
+/* Called with lock held when timer_sys_ticks has just advanced to a new value */
+static void timer_wheel_enter(void)
+{
+    uint32_t ticks = timer_sys_ticks;
 
-    // Didn't insert before another timer, so must be last.
-    ns_list_add_to_end(&system_timer_list, timer);
+    // Top down, so timers moving down from a level are not run twice
+    if ((ticks & ((UINT32_C(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1)) == 0) {
+        timer_wheel_redistribute(&system_timer_overflow);
+    }
+    for (int level = TIMER_WHEEL_LEVELS - 1; level >= 0; level--) {
+        uint8_t shift = level * TIMER_WHEEL_BITS;
+        if (ticks & ((UINT32_C(1) << shift) - 1)) {
+            // Not at the start of a slot of this level
+            continue;
+        }
+        uint8_t slot = (ticks >> shift) & TIMER_WHEEL_MASK;
+        if (system_timer_wheel_used[level] & (UINT32_C(1) << slot)) {
+            system_timer_wheel_used[level] &= ~(UINT32_C(1) << slot);
+            timer_wheel_redistribute(&system_timer_wheel[level][slot]);
+        }
+    }
+}
+
+/* Next tick at which timer_wheel_enter() has something to do, false if none */
+static bool timer_wheel_next_stop(uint32_t *next)
+{
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (system_timer_wheel_used[level]) {
+            // Only slots after the current one of each level can be in use
+            uint8_t shift = level * TIMER_WHEEL_BITS;
+            uint32_t rotation = timer_sys_ticks & ~((UINT32_C(1) << (shift + TIMER_WHEEL_BITS)) - 1);
+            *next = rotation | ((uint32_t) timer_wheel_first_slot(system_timer_wheel_used[level]) << shift);
+            return true;
+        }
+    }
+    if (!ns_list_is_empty(&system_timer_overflow)) {
+        *next = (timer_sys_ticks | ((UINT32_C(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1)) + 1;
+        return true;
+    }
+    return false;
+}
+
+/* Earliest pending timer, called with lock held */
+static sys_timer_struct_s *timer_sys_first(void)
+{
+    timer_wheel_slot_t *list = &system_timer_overflow;
+
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (system_timer_wheel_used[level]) {
+            list = &system_timer_wheel[level][timer_wheel_first_slot(system_timer_wheel_used[level])];
+            if (level == 0) {
+                // Every timer of a level 0 slot launches on the same tick
+                return ns_list_get_first(list);
+            }
+            break;
+        }
+    }
+
+    sys_timer_struct_s *first = NULL;
+    ns_list_foreach(sys_timer_struct_s, cur, list) {
+        if (!first || TICKS_BEFORE(cur->launch_time, first->launch_time)) {
+            first = cur;
+        }
+    }
+    return first;
+}
+
+/* Pending timer of a tasklet with the event ID, earliest first. Lock held. */
+static sys_timer_struct_s *timer_sys_find(uint8_t event_id, int8_t tasklet_id)
+{
+    sys_timer_struct_s *first = NULL;
+
+    ns_list_foreach(sys_timer_struct_s, cur, timer_index_bucket(tasklet_id, event_id)) {
+        if (cur->event.data.receiver == tasklet_id && cur->event.data.event_id == event_id &&
+                (!first || TICKS_BEFORE(cur->launch_time, first->launch_time))) {
+            first = cur;
+        }
+    }
+    return first;
 }
 
 /* Called internally with lock held */
@@ -228,6 +718,7 @@ static arm_event_storage_t *eventOS_event_timer_request_at_(const arm_event_t *e
         eventOS_event_send_timer_allocated(&timer->event);
     } else {
         timer_sys_add(timer);
+        tickless_timer_added(timer);
     }
 
     return &timer->event;
@@ -236,6 +727,7 @@ static arm_event_storage_t *eventOS_event_timer_request_at_(const arm_event_t *e
 arm_event_storage_t *eventOS_event_timer_request_at(const arm_event_t *event, uint32_t at)
 {
     platform_enter_critical();
+    tickless_ticks_update();
 
     arm_event_storage_t *ret = eventOS_event_timer_request_at_(event, at, 0);
 
@@ -247,6 +739,7 @@ arm_event_storage_t *eventOS_event_timer_request_at(const arm_event_t *event, ui
 arm_event_storage_t *eventOS_event_timer_request_in(const arm_event_t *event, int32_t in)
 {
     platform_enter_critical();
+    tickless_ticks_update();
 
     arm_event_storage_t *ret = eventOS_event_timer_request_at_(event, timer_sys_ticks + in, 0);
 
@@ -263,6 +756,7 @@ arm_event_storage_t *eventOS_event_timer_request_every(const arm_event_t *event,
     }
 
     platform_enter_critical();
+    tickless_ticks_update();
 
     arm_event_storage_t *ret = eventOS_event_timer_request_at_(event, timer_sys_ticks + period, period);
 
@@ -297,6 +791,7 @@ int8_t eventOS_event_timer_request(uint8_t event_id, uint8_t event_type, int8_t
     }
 
     platform_enter_critical();
+    tickless_ticks_update();
     arm_event_storage_t *ret = eventOS_event_timer_request_at_(&event, timer_sys_ticks + time, 0);
     platform_exit_critical();
     return ret?0:-1;
@@ -307,11 +802,10 @@ int8_t eventOS_event_timer_cancel(uint8_t event_id, int8_t tasklet_id)
     platform_enter_critical();
 
     /* First check pending timers */
-    ns_list_foreach(sys_timer_struct_s, cur, &system_timer_list) {
-        if (cur->event.data.receiver == tasklet_id && cur->event.data.event_id == event_id) {
-            eventOS_cancel(&cur->event);
-            goto done;
-        }
+    sys_timer_struct_s *timer = timer_sys_find(event_id, tasklet_id);
+    if (timer) {
+        eventOS_cancel(&timer->event);
+        goto done;
     }
 
     /* No pending timer, so check for already-pending event */
@@ -335,7 +829,8 @@ uint32_t eventOS_event_timer_shortest_active_timer(void)
     uint32_t ret_val = 0;
 
     platform_enter_critical();
-    sys_timer_struct_s *first = ns_list_get_first(&system_timer_list);
+    tickless_ticks_update();
+    sys_timer_struct_s *first = timer_sys_first();
     if (first == NULL) {
         // Weird API has 0 for "no events"
         ret_val = 0;
@@ -350,24 +845,23 @@ uint32_t eventOS_event_timer_shortest_active_timer(void)
     return eventOS_event_timer_ticks_to_ms(ret_val);
 }
 
-void system_timer_tick_update(uint32_t ticks)
+/* Called internally with lock held */
+static void timer_sys_advance(uint32_t ticks)
 {
-    platform_enter_critical();
-    //Keep runtime time
-    timer_sys_ticks += ticks;
-    ns_list_foreach_safe(sys_timer_struct_s, cur, &system_timer_list) {
-        if (TICKS_BEFORE_OR_AT(cur->launch_time, timer_sys_ticks)) {
-            // Unthread from our list
-            ns_list_remove(&system_timer_list, cur);
-            // Make it an event (can't fail - no allocation)
-            // event system will call our timer_sys_event_free on event delivery.
-            eventOS_event_send_timer_allocated(&cur->event);
-        } else {
-            // List is ordered, so as soon as we see a later event, we're done.
-            break;
-        }
+    //Keep runtime time, stopping at every tick that has timers to move or launch
+    uint32_t target = timer_sys_ticks + ticks;
+    uint32_t next;
+    while (timer_wheel_next_stop(&next) && TICKS_BEFORE_OR_AT(next, target)) {
+        timer_sys_ticks = next;
+        timer_wheel_enter();
     }
+    timer_sys_ticks = target;
+}
 
+void system_timer_tick_update(uint32_t ticks)
+{
+    platform_enter_critical();
+    timer_sys_advance(ticks);
     platform_exit_critical();
 }
 
@@ -21,12 +21,18 @@ extern "C" {
 #endif
 
 #include "eventOS_event.h"
+#include "platform/eventloop_config.h"
 
 /* We borrow base event storage, including its list link, and add a time field */
 typedef struct sys_timer_struct_s {
     arm_event_storage_t event;
     uint32_t launch_time; // tick value
     uint32_t period;
+    uint8_t wheel_slot; // level * slots per level + slot, while pending
+    ns_list_link_t index_link; // on the (tasklet, event_id) index, while pending
+#ifdef NS_EVENTLOOP_PROFILING
+    uint32_t queued_at; // profiling timestamp when launched
+#endif
 } sys_timer_struct_s;
 
 
@@ -53,6 +59,17 @@ void timer_sys_event_cancel_critical(struct arm_event_storage *event);
  * */
 void system_timer_tick_update(uint32_t ticks);
 
+/**
+ * System Timer update after sleep, keeping the part of a tick left over
+ * for the next update. Tickless event loop only.
+ *
+ * \param ms Time in milliseconds
+ *
+ * \return none
+ *
+ * */
+void system_timer_ms_update(uint32_t ms);
+
 #ifdef __cplusplus
 }
 #endif
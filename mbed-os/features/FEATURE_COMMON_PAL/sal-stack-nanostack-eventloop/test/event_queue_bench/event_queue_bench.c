@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Time spent with interrupts disabled by event_core_write() and
+ * event_core_read() against the number of queued events. The critical
+ * section stubs time the outermost section. The priority sorted list the
+ * queue used before is timed the same way for comparison.
+ *
+ * Bursts of events deeper than the static pool are then counted in heap
+ * calls. Run with CFLAGS=-DMBED_CONF_NANOSTACK_EVENTLOOP_EVENT_SLAB_SIZE=0
+ * for the per-event allocation without slabs.
+ *
+ * Last, deferred calls are checked to coalesce posts and to run again
+ * when posted from their own handler, and the post is timed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../source/event.c"
+
+#define BENCH_DEPTH_MAX     512
+#define BENCH_ROUNDS        2000
+#define BENCH_BURST_DEPTH   50
+#define BENCH_BURST_ROUNDS  100
+
+static int critical_nesting;
+static uint64_t critical_start;
+static uint64_t critical_ns;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void platform_enter_critical(void)
+{
+    if (critical_nesting++ == 0) {
+        critical_start = now_ns();
+    }
+}
+
+void platform_exit_critical(void)
+{
+    if (--critical_nesting == 0) {
+        critical_ns += now_ns() - critical_start;
+    }
+}
+
+/* Rest of the eventOS and libService dependencies of event.c */
+static int heap_allocs;
+static int heap_frees;
+void *ns_dyn_mem_alloc(ns_mem_block_size_t size) { heap_allocs++; return malloc(size); }
+void *ns_dyn_mem_temporary_alloc(ns_mem_block_size_t size) { heap_allocs++; return malloc(size); }
+void ns_dyn_mem_free(void *block) { heap_frees++; free(block); }
+void eventOS_scheduler_signal(void) {}
+void eventOS_scheduler_idle(void) {}
+void timer_sys_init(void) {}
+void timer_sys_disable(void) {}
+int8_t timer_sys_wakeup(void) { return 0; }
+void timer_sys_event_free(arm_event_storage_t *event) { (void)event; }
+void timer_sys_event_cancel_critical(arm_event_storage_t *event) { (void)event; }
+void system_timer_tick_update(uint32_t ticks) { (void)ticks; }
+int8_t ns_timer_sleep(void) { return 0; }
+
+/* The queue before: one list sorted by priority */
+static NS_LIST_DEFINE(sorted_queue, arm_event_storage_t, link);
+
+static void sorted_write(arm_event_storage_t *event)
+{
+    platform_enter_critical();
+    bool added = false;
+    ns_list_foreach(arm_event_storage_t, event_tmp, &sorted_queue) {
+        if (event_tmp->data.priority > event->data.priority) {
+            ns_list_add_before(&sorted_queue, event_tmp, event);
+            added = true;
+            break;
+        }
+    }
+    if (!added) {
+        ns_list_add_to_end(&sorted_queue, event);
+    }
+    platform_exit_critical();
+}
+
+static arm_event_storage_t *sorted_read(void)
+{
+    platform_enter_critical();
+    arm_event_storage_t *event = ns_list_get_first(&sorted_queue);
+    if (event) {
+        ns_list_remove(&sorted_queue, event);
+    }
+    platform_exit_critical();
+    return event;
+}
+
+static arm_event_storage_t events[BENCH_DEPTH_MAX + 1];
+
+static void fill(int depth, void (*write)(arm_event_storage_t *))
+{
+    srand(depth);
+    for (int i = 0; i < depth; i++) {
+        events[i].data.priority = rand() % EVENT_PRIORITY_COUNT;
+        write(&events[i]);
+    }
+}
+
+/* Average ns of one write of a low priority event, the worst case of the
+ * sorted list, and the read of the head at the given depth */
+static double bench_buckets(int depth)
+{
+    fill(depth, event_core_write);
+    arm_event_storage_t *event = &events[depth];
+    critical_ns = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        event->data.priority = ARM_LIB_LOW_PRIORITY_EVENT;
+        event_core_write(event);
+        event = event_core_read();
+    }
+    double result = (double)critical_ns / BENCH_ROUNDS;
+    while (event_core_read());
+    return result;
+}
+
+static double bench_sorted(int depth)
+{
+    fill(depth, sorted_write);
+    arm_event_storage_t *event = &events[depth];
+    critical_ns = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        event->data.priority = ARM_LIB_LOW_PRIORITY_EVENT;
+        sorted_write(event);
+        event = sorted_read();
+    }
+    double result = (double)critical_ns / BENCH_ROUNDS;
+    while (sorted_read());
+    return result;
+}
+
+static void burst_handler(arm_event_t *event)
+{
+    (void)event;
+}
+
+static void bench_burst(void)
+{
+    eventOS_pool_stats_t stats;
+    arm_event_t event = { .event_type = 1, .priority = ARM_LIB_MED_PRIORITY_EVENT };
+
+    event.receiver = eventOS_event_handler_create(burst_handler, 0);
+    while (eventOS_scheduler_dispatch_event());
+    heap_allocs = 0;
+    heap_frees = 0;
+    for (int round = 0; round < BENCH_BURST_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_BURST_DEPTH; i++) {
+            eventOS_event_send(&event);
+        }
+        while (eventOS_scheduler_dispatch_event());
+    }
+    eventOS_event_pool_stats_get(&stats);
+    printf("burst_depth,rounds,heap_allocs,heap_frees,pool_size,pool_high_water,pool_slabs\n");
+    printf("%d,%d,%d,%d,%u,%u,%u\n", BENCH_BURST_DEPTH, BENCH_BURST_ROUNDS, heap_allocs, heap_frees,
+           stats.size, stats.high_water, stats.slabs);
+}
+
+static eventOS_deferred_t deferred;
+static int deferred_runs;
+static int deferred_reposts;
+
+static void deferred_handler(arm_event_t *event)
+{
+    (void)event;
+    deferred_runs++;
+    if (deferred_reposts > 0) {
+        deferred_reposts--;
+        eventOS_deferred_post(&deferred);
+    }
+}
+
+/* Returns the number of failed checks */
+static int bench_deferred(void)
+{
+    int errors = 0;
+    arm_event_t event = { .event_type = 1, .priority = ARM_LIB_HIGH_PRIORITY_EVENT };
+
+    event.receiver = eventOS_event_handler_create(deferred_handler, 0);
+    while (eventOS_scheduler_dispatch_event());
+    eventOS_deferred_init(&deferred, &event);
+
+    deferred_runs = 0;
+    for (int i = 0; i < 10; i++) {
+        eventOS_deferred_post(&deferred);
+    }
+    while (eventOS_scheduler_dispatch_event());
+    errors += deferred_runs != 1;
+    deferred_runs = 0;
+    deferred_reposts = 3;
+    eventOS_deferred_post(&deferred);
+    while (eventOS_scheduler_dispatch_event());
+    errors += deferred_runs != 4;
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        deferred.pending = 0;
+        eventOS_deferred_post(&deferred);
+    }
+    double post_ns = (double)(now_ns() - start) / BENCH_ROUNDS;
+    eventOS_deferred_delete(&deferred);
+    errors += eventOS_scheduler_dispatch_event();
+
+    printf("deferred_post_ns\n%.0f\n", post_ns);
+    return errors;
+}
+
+int main(void)
+{
+    eventOS_scheduler_init();
+
+    printf("depth,buckets_ns,sorted_list_ns\n");
+    for (int depth = 0; depth <= BENCH_DEPTH_MAX; depth = depth ? depth * 2 : 1) {
+        printf("%d,%.0f,%.0f\n", depth, bench_buckets(depth), bench_sorted(depth));
+    }
+    bench_burst();
+    if (bench_deferred()) {
+        printf("deferred call runs wrong\n");
+        return 1;
+    }
+    return 0;
+}
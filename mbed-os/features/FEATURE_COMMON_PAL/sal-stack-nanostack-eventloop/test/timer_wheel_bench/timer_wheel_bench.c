@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Time spent with interrupts disabled by system timer insert, cancel and
+ * tick processing against the number of pending timers, for the timing
+ * wheel and for the sorted list the timers used before. Every timer is
+ * also checked to launch exactly on its tick, with one tick at a time and
+ * with random jumps of the tick count as after sleep. Cancel by tasklet and
+ * event ID, as eventOS_event_timer_cancel() does, is measured too, and the
+ * longest chain of its index is checked against BENCH_INDEX_CHAIN_MAX.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../source/system_timer.c"
+
+#define BENCH_TIMERS_MAX    10000
+#define BENCH_DELAY_MAX     60000   // ticks, 10 minutes
+#define BENCH_JUMP_MAX      500
+// Timers compared by a cancel by ID, with distinct IDs
+#define BENCH_INDEX_CHAIN_MAX   8
+
+static int critical_nesting;
+static uint64_t critical_start;
+static uint64_t critical_ns;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void platform_enter_critical(void)
+{
+    if (critical_nesting++ == 0) {
+        critical_start = now_ns();
+    }
+}
+
+void platform_exit_critical(void)
+{
+    if (--critical_nesting == 0) {
+        critical_ns += now_ns() - critical_start;
+    }
+}
+
+/* Launches are checked against the tick count range of the update */
+static uint32_t update_start;
+static int launched;
+static int errors;
+
+void eventOS_event_send_timer_allocated(arm_event_storage_t *event)
+{
+    sys_timer_struct_s *timer = NS_CONTAINER_OF(event, sys_timer_struct_s, event);
+    if (TICKS_BEFORE_OR_AT(timer->launch_time, update_start) || TICKS_BEFORE(timer_sys_ticks, timer->launch_time)) {
+        errors++;
+    }
+    launched++;
+    event->state = ARM_LIB_EVENT_QUEUED;
+    timer_sys_event_free(event);
+}
+
+void eventOS_cancel(arm_event_storage_t *event)
+{
+    timer_sys_event_cancel_critical(event);
+    timer_sys_event_free(event);
+}
+
+/* Rest of the eventOS and libService dependencies of system_timer.c */
+void *ns_dyn_mem_alloc(ns_mem_block_size_t size) { return malloc(size); }
+void ns_dyn_mem_free(void *block) { free(block); }
+bool event_tasklet_handler_id_valid(uint8_t tasklet_id) { (void)tasklet_id; return true; }
+arm_event_storage_t *eventOS_event_find_by_id_critical(uint8_t tasklet_id, uint8_t event_id) { (void)tasklet_id; (void)event_id; return NULL; }
+int8_t eventOS_callback_timer_register(void (*handler)(int8_t, uint16_t)) { (void)handler; return 0; }
+int8_t eventOS_callback_timer_start(int8_t id, uint16_t slots) { (void)id; (void)slots; return 0; }
+int8_t eventOS_callback_timer_stop(int8_t id) { (void)id; return 0; }
+
+/* The timers before: one list sorted by launch time */
+static NS_LIST_DEFINE(sorted_list, sys_timer_struct_s, event.link);
+static sys_timer_struct_s sorted_pool[BENCH_TIMERS_MAX];
+
+static void sorted_add(sys_timer_struct_s *timer)
+{
+    platform_enter_critical();
+    ns_list_foreach(sys_timer_struct_s, t, &sorted_list) {
+        if (TICKS_BEFORE(timer->launch_time, t->launch_time)) {
+            ns_list_add_before(&sorted_list, t, timer);
+            platform_exit_critical();
+            return;
+        }
+    }
+    ns_list_add_to_end(&sorted_list, timer);
+    platform_exit_critical();
+}
+
+static void sorted_cancel(sys_timer_struct_s *timer)
+{
+    platform_enter_critical();
+    ns_list_remove(&sorted_list, timer);
+    platform_exit_critical();
+}
+
+static void sorted_tick(void)
+{
+    platform_enter_critical();
+    timer_sys_ticks++;
+    ns_list_foreach_safe(sys_timer_struct_s, cur, &sorted_list) {
+        if (!TICKS_BEFORE_OR_AT(cur->launch_time, timer_sys_ticks)) {
+            break;
+        }
+        ns_list_remove(&sorted_list, cur);
+        launched++;
+    }
+    platform_exit_critical();
+}
+
+static uint32_t delays[BENCH_TIMERS_MAX];
+static arm_event_storage_t *wheel_timers[BENCH_TIMERS_MAX];
+
+static void make_delays(int count)
+{
+    srand(count);
+    for (int i = 0; i < count; i++) {
+        delays[i] = 1 + rand() % BENCH_DELAY_MAX;
+    }
+}
+
+static double per_op(uint64_t ns, int ops)
+{
+    return ops ? (double)ns / ops : 0;
+}
+
+/* Average ns per insert, per cancel of every other timer and per launch */
+static void bench_wheel(int count, double result[3], bool jump)
+{
+    const arm_event_t event = { .receiver = 1, .priority = ARM_LIB_MED_PRIORITY_EVENT };
+
+    make_delays(count);
+    critical_ns = 0;
+    for (int i = 0; i < count; i++) {
+        wheel_timers[i] = eventOS_event_timer_request_in(&event, delays[i]);
+    }
+    result[0] = per_op(critical_ns, count);
+
+    critical_ns = 0;
+    for (int i = 0; i < count; i += 2) {
+        platform_enter_critical();
+        eventOS_cancel(wheel_timers[i]);
+        platform_exit_critical();
+    }
+    result[1] = per_op(critical_ns, (count + 1) / 2);
+
+    critical_ns = 0;
+    launched = 0;
+    for (uint32_t elapsed = 0; elapsed < BENCH_DELAY_MAX;) {
+        uint32_t ticks = jump ? 1 + rand() % BENCH_JUMP_MAX : 1;
+        update_start = timer_sys_ticks;
+        system_timer_tick_update(ticks);
+        elapsed += ticks;
+    }
+    if (launched != count / 2 || eventOS_event_timer_shortest_active_timer() != 0) {
+        errors++;
+    }
+    result[2] = per_op(critical_ns, launched);
+}
+
+/* Average ns per eventOS_event_timer_cancel() of every other timer */
+/* Most timers sharing an index bucket, of both tables while the index grows */
+static unsigned index_chain_longest(void)
+{
+    unsigned longest = 0;
+    for (uint32_t bucket = 0; bucket < system_timer_index_size; bucket++) {
+        unsigned chain = ns_list_count(&system_timer_index[bucket]);
+        if (system_timer_index_old && bucket < system_timer_index_size / 2) {
+            chain += ns_list_count(&system_timer_index_old[bucket]);
+        }
+        if (chain > longest) {
+            longest = chain;
+        }
+    }
+    return longest;
+}
+
+static double bench_cancel_id(int count, unsigned *chain)
+{
+    arm_event_t event = { .priority = ARM_LIB_MED_PRIORITY_EVENT };
+
+    make_delays(count);
+    for (int i = 0; i < count; i++) {
+        event.event_id = i & 0xff;
+        event.receiver = (i >> 8) & 0x7f;
+        eventOS_event_timer_request_in(&event, delays[i]);
+    }
+    *chain = index_chain_longest();
+
+    critical_ns = 0;
+    for (int i = 0; i < count; i += 2) {
+        if (eventOS_event_timer_cancel(i & 0xff, (i >> 8) & 0x7f) != 0) {
+            errors++;
+        }
+    }
+    double result = per_op(critical_ns, (count + 1) / 2);
+
+    launched = 0;
+    for (uint32_t elapsed = 0; elapsed < BENCH_DELAY_MAX; elapsed += BENCH_JUMP_MAX) {
+        update_start = timer_sys_ticks;
+        system_timer_tick_update(BENCH_JUMP_MAX);
+    }
+    if (launched != count / 2 || eventOS_event_timer_shortest_active_timer() != 0) {
+        errors++;
+    }
+    return result;
+}
+
+static void bench_sorted(int count, double result[3])
+{
+    make_delays(count);
+    critical_ns = 0;
+    for (int i = 0; i < count; i++) {
+        sorted_pool[i].launch_time = timer_sys_ticks + delays[i];
+        sorted_add(&sorted_pool[i]);
+    }
+    result[0] = per_op(critical_ns, count);
+
+    critical_ns = 0;
+    for (int i = 0; i < count; i += 2) {
+        sorted_cancel(&sorted_pool[i]);
+    }
+    result[1] = per_op(critical_ns, (count + 1) / 2);
+
+    critical_ns = 0;
+    launched = 0;
+    for (uint32_t elapsed = 0; elapsed < BENCH_DELAY_MAX; elapsed++) {
+        sorted_tick();
+    }
+    result[2] = per_op(critical_ns, launched);
+}
+
+int main(void)
+{
+    double wheel[3], sorted[3], jump[3], cancel_id;
+    unsigned chain;
+
+    timer_sys_init();
+    // Start close to the counter wrap, the wheel must cope with it
+    timer_sys_ticks = UINT32_MAX - BENCH_DELAY_MAX / 2;
+
+    printf("timers,wheel_insert_ns,sorted_insert_ns,wheel_cancel_ns,sorted_cancel_ns,"
+           "wheel_launch_ns,sorted_launch_ns,wheel_jump_launch_ns,wheel_cancel_id_ns,index_chain\n");
+    for (int count = 10; count <= BENCH_TIMERS_MAX; count *= 10) {
+        bench_wheel(count, wheel, false);
+        bench_wheel(count, jump, true);
+        bench_sorted(count, sorted);
+        cancel_id = bench_cancel_id(count, &chain);
+        printf("%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%u\n", count,
+               wheel[0], sorted[0], wheel[1], sorted[1], wheel[2], sorted[2], jump[2], cancel_id, chain);
+        if (chain > BENCH_INDEX_CHAIN_MAX) {
+            printf("%u timers share an index bucket, more than %d\n", chain, BENCH_INDEX_CHAIN_MAX);
+            errors++;
+        }
+    }
+    if (errors) {
+        printf("%d timers launched on the wrong tick or not cancelled\n", errors);
+        return 1;
+    }
+    return 0;
+}
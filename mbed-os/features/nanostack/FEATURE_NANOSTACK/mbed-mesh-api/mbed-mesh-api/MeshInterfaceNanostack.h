@@ -56,6 +56,35 @@ public:
     */
     virtual const char *get_mac_address();
 
+    /** Get the Nanostack network interface ID
+    /return     interface ID or negative if not initialized
+    */
+    int8_t get_interface_id() const;
+
+    /** Register a callback for network status changes
+     *
+     *  Called from the Nanostack event loop thread with the stack locked,
+     *  so it must not block. MESH_CONNECTED is reported when the bootstrap
+     *  is ready and MESH_GLOBAL_ADDRESS_READY when the global address can
+     *  be used.
+     *
+     *  @param status_cb    callback, or NULL to remove
+     */
+    void attach(Callback<void(mesh_connection_status_t)> status_cb);
+
+    /** Read the bootstrap timeline of the last connect
+     *
+     *  @param events   where the timeline entries are copied, oldest first
+     *  @param count    number of entries that fit into events
+     *  @return         number of entries copied
+     */
+    int get_bootstrap_timeline(mesh_bootstrap_event_t *events, int count);
+
+    /** Get the printable name of a bootstrap phase
+    /return     phase name
+    */
+    static const char *get_bootstrap_phase_name(uint8_t phase);
+
     /**
      * \brief Callback from C-layer
      * \param state state of the network
@@ -86,6 +115,7 @@ protected:
     char ip_addr_str[40];
     char mac_addr_str[24];
     Semaphore connect_semaphore;
+    Callback<void(mesh_connection_status_t)> _connection_status_cb;
 };
 
 #endif /* MESHINTERFACENANOSTACK_H */
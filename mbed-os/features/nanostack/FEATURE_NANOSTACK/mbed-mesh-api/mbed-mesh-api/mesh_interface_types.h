@@ -17,6 +17,8 @@
 #ifndef __MESH_INTERFACE_TYPES_H__
 #define __MESH_INTERFACE_TYPES_H__
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -47,9 +49,35 @@ typedef enum {
     MESH_CONNECTED = 0,             /*<! connected to network */
     MESH_DISCONNECTED,              /*<! disconnected from network */
     MESH_BOOTSTRAP_START_FAILED,    /*<! error during bootstrap start */
-    MESH_BOOTSTRAP_FAILED           /*<! error in bootstrap */
+    MESH_BOOTSTRAP_FAILED,          /*<! error in bootstrap */
+    MESH_GLOBAL_ADDRESS_READY       /*<! global address available after connect */
 } mesh_connection_status_t;
 
+/*
+ * Bootstrap phases recorded in the connect timeline. Nanostack only reports
+ * the end of the bootstrap, so the intermediate phases are detected by
+ * probing the stack state while the bootstrap runs.
+ */
+typedef enum {
+    MESH_PHASE_CONNECT = 0,         /*<! connect requested */
+    MESH_PHASE_BOOTSTRAP_START,     /*<! interface up, network scan started */
+    MESH_PHASE_NETWORK_FOUND,       /*<! scan done, PAN selected */
+    MESH_PHASE_PARENT_FOUND,        /*<! Thread MLE parent or ND border router known */
+    MESH_PHASE_CHILD_ID,            /*<! 16-bit short address assigned (Thread child ID) */
+    MESH_PHASE_ADDRESS_REGISTERED,  /*<! global address registered */
+    MESH_PHASE_RPL_JOINED,          /*<! RPL DODAG joined with a preferred parent (6LoWPAN ND) */
+    MESH_PHASE_BOOTSTRAP_READY,     /*<! Nanostack reported bootstrap ready */
+    MESH_PHASE_BOOTSTRAP_FAILED     /*<! bootstrap failed, retried after a delay */
+} mesh_bootstrap_phase_t;
+
+/*
+ * Bootstrap timeline entry
+ */
+typedef struct {
+    uint32_t time_ms;   /*<! time since connect was requested */
+    uint8_t phase;      /*<! mesh_bootstrap_phase_t */
+} mesh_bootstrap_event_t;
+
 /*
  * Mesh device types
  */
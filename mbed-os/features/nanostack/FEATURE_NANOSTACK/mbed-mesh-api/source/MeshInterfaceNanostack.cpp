@@ -17,6 +17,7 @@
 #include "MeshInterfaceNanostack.h"
 #include "NanostackInterface.h"
 #include "mesh_system.h"
+#include "include/mesh_timeline.h"
 
 MeshInterfaceNanostack::MeshInterfaceNanostack()
     : phy(NULL), _network_interface_id(-1), _device_id(-1), eui64(),
@@ -49,6 +50,10 @@ void MeshInterfaceNanostack::mesh_network_handler(mesh_connection_status_t statu
         connect_semaphore.release();
     }
 
+    if (_connection_status_cb) {
+        _connection_status_cb(status);
+    }
+
     nanostack_unlock();
 }
 
@@ -97,3 +102,29 @@ const char *MeshInterfaceNanostack::get_mac_address()
 {
     return mac_addr_str;
 }
+
+int8_t MeshInterfaceNanostack::get_interface_id() const
+{
+    return _network_interface_id;
+}
+
+void MeshInterfaceNanostack::attach(Callback<void(mesh_connection_status_t)> status_cb)
+{
+    nanostack_lock();
+    _connection_status_cb = status_cb;
+    nanostack_unlock();
+}
+
+int MeshInterfaceNanostack::get_bootstrap_timeline(mesh_bootstrap_event_t *events, int count)
+{
+    nanostack_lock();
+    int ret = mesh_timeline_read(events, count);
+    nanostack_unlock();
+
+    return ret;
+}
+
+const char *MeshInterfaceNanostack::get_bootstrap_phase_name(uint8_t phase)
+{
+    return mesh_timeline_phase_name(phase);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_MESH_TIMELINE__
+#define __INCLUDE_MESH_TIMELINE__
+#include "ns_types.h"
+#include "mbed-mesh-api/mesh_interface_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * \brief Clear the timeline and record the connect request.
+ * Times of the later phases are relative to this.
+ */
+void mesh_timeline_start(void);
+
+/*
+ * \brief Record a phase of the bootstrap.
+ * Starting a bootstrap attempt forgets the phases probed in the previous one.
+ *
+ * \param phase bootstrap phase
+ */
+void mesh_timeline_mark(mesh_bootstrap_phase_t phase);
+
+/*
+ * \brief Check if a phase has been recorded in the current bootstrap attempt.
+ */
+bool mesh_timeline_phase_seen(mesh_bootstrap_phase_t phase);
+
+/*
+ * \brief Probe the stack state and record the phases reached since the last probe.
+ *
+ * \param interface_id network interface
+ * \param type network type, selects the phases to probe
+ *
+ * \return true if phases are still missing and probing should continue
+ */
+bool mesh_timeline_probe(int8_t interface_id, mesh_network_type_t type);
+
+/*
+ * \brief Read the timeline, oldest entry first.
+ *
+ * \param events where entries are copied
+ * \param count size of events
+ *
+ * \return number of entries copied
+ */
+int mesh_timeline_read(mesh_bootstrap_event_t *events, int count);
+
+/*
+ * \brief Printable name of a bootstrap phase.
+ */
+const char *mesh_timeline_phase_name(uint8_t phase);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __INCLUDE_MESH_TIMELINE__ */
@@ -36,6 +36,8 @@ static uint8_t app_stack_heap[MBED_CONF_MBED_MESH_API_HEAP_SIZE + 1];
 static uint8_t *app_stack_heap;
 #endif
 static bool mesh_initialized = false;
+/* Heap statistics, read with ns_dyn_mem_get_mem_stat() */
+static mem_stat_t app_stack_heap_stats;
 
 /*
  * Heap error handler, called when heap problem is detected.
@@ -66,7 +68,7 @@ void mesh_system_init(void)
         MBED_ASSERT(app_stack_heap);
 #endif
         ns_hal_init(app_stack_heap, MBED_CONF_MBED_MESH_API_HEAP_SIZE,
-                    mesh_system_heap_error_handler, NULL);
+                    mesh_system_heap_error_handler, &app_stack_heap_stats);
         eventOS_scheduler_mutex_wait();
         net_init_core();
         eventOS_scheduler_mutex_release();
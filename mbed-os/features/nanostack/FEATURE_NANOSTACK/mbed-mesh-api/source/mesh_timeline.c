@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "eventOS_event_timer.h"
+#include "net_interface.h"
+#include "net_rpl.h"
+#include "thread_management_if.h"
+#include "include/mesh_timeline.h"
+
+#define HAVE_DEBUG 1
+#include "ns_trace.h"
+#define TRACE_GROUP  "m6time"
+
+#define MESH_TIMELINE_SIZE  MBED_CONF_MBED_MESH_API_BOOTSTRAP_TIMELINE_SIZE
+
+#if MESH_TIMELINE_SIZE < 1 || MESH_TIMELINE_SIZE > 255
+#error "mbed-mesh-api.bootstrap-timeline-size must be 1-255"
+#endif
+
+#define PHASE_BIT(phase)    (1u << (phase))
+
+/* Phases that are probed from the stack state, per network type */
+#define PROBED_PHASES_THREAD (PHASE_BIT(MESH_PHASE_NETWORK_FOUND) | \
+                              PHASE_BIT(MESH_PHASE_PARENT_FOUND) | \
+                              PHASE_BIT(MESH_PHASE_CHILD_ID) | \
+                              PHASE_BIT(MESH_PHASE_ADDRESS_REGISTERED))
+#define PROBED_PHASES_ND     (PHASE_BIT(MESH_PHASE_NETWORK_FOUND) | \
+                              PHASE_BIT(MESH_PHASE_PARENT_FOUND) | \
+                              PHASE_BIT(MESH_PHASE_ADDRESS_REGISTERED) | \
+                              PHASE_BIT(MESH_PHASE_RPL_JOINED))
+
+/* Ring buffer, when full the oldest entries are overwritten */
+static mesh_bootstrap_event_t timeline[MESH_TIMELINE_SIZE];
+static uint8_t timeline_head;
+static uint8_t timeline_count;
+static uint32_t start_ticks;
+/* Phases recorded in the current bootstrap attempt */
+static uint16_t phases_seen;
+
+static const char *const phase_names[] = {
+    "connect",
+    "bootstrap_start",
+    "network_found",
+    "parent_found",
+    "child_id",
+    "address_registered",
+    "rpl_joined",
+    "bootstrap_ready",
+    "bootstrap_failed"
+};
+
+static void timeline_add(mesh_bootstrap_phase_t phase)
+{
+    mesh_bootstrap_event_t *event = &timeline[(timeline_head + timeline_count) % MESH_TIMELINE_SIZE];
+
+    if (timeline_count < MESH_TIMELINE_SIZE) {
+        timeline_count++;
+    } else {
+        timeline_head = (timeline_head + 1) % MESH_TIMELINE_SIZE;
+    }
+    event->time_ms = eventOS_event_timer_ticks_to_ms(eventOS_event_timer_ticks() - start_ticks);
+    event->phase = phase;
+    tr_debug("Bootstrap phase %s at %lu ms", mesh_timeline_phase_name(phase), (unsigned long)event->time_ms);
+}
+
+void mesh_timeline_start(void)
+{
+    timeline_head = 0;
+    timeline_count = 0;
+    phases_seen = 0;
+    start_ticks = eventOS_event_timer_ticks();
+    timeline_add(MESH_PHASE_CONNECT);
+}
+
+void mesh_timeline_mark(mesh_bootstrap_phase_t phase)
+{
+    if (phase == MESH_PHASE_BOOTSTRAP_START) {
+        phases_seen = 0;
+    }
+    phases_seen |= PHASE_BIT(phase);
+    timeline_add(phase);
+}
+
+bool mesh_timeline_phase_seen(mesh_bootstrap_phase_t phase)
+{
+    return (phases_seen & PHASE_BIT(phase)) != 0;
+}
+
+static void probe_phase(mesh_bootstrap_phase_t phase, bool reached)
+{
+    if (reached && !mesh_timeline_phase_seen(phase)) {
+        mesh_timeline_mark(phase);
+    }
+}
+
+static bool rpl_parent_selected(void)
+{
+    uint8_t instances[17];
+    rpl_dodag_info_t info;
+
+    /* The first instance is enough, a node joins the DODAG of its border router */
+    if (rpl_instance_list_read(instances, sizeof(instances)) == 0) {
+        return false;
+    }
+    memset(&info, 0, sizeof(info));
+    if (instances[0] & RPL_INSTANCE_LOCAL) {
+        memcpy(info.dodag_id, &instances[1], 16);
+    }
+    if (!rpl_read_dodag_info(&info, instances[0])) {
+        return false;
+    }
+    return (info.parent_flags & RPL_PRIMARY_PARENT_SET) != 0;
+}
+
+bool mesh_timeline_probe(int8_t interface_id, mesh_network_type_t type)
+{
+    link_layer_address_s link_address;
+    network_layer_address_s nd_address;
+    uint8_t address[16];
+    uint16_t probed;
+
+    if (arm_nwk_mac_address_read(interface_id, &link_address) == 0) {
+        probe_phase(MESH_PHASE_NETWORK_FOUND, link_address.PANId != 0xffff);
+        if (type == MESH_TYPE_THREAD) {
+            probe_phase(MESH_PHASE_CHILD_ID, link_address.mac_short < 0xfffe);
+        }
+    }
+    if (type == MESH_TYPE_THREAD) {
+        probe_phase(MESH_PHASE_PARENT_FOUND,
+                    thread_management_get_parent_address(interface_id, address) == 0);
+        probed = PROBED_PHASES_THREAD;
+    } else {
+        probe_phase(MESH_PHASE_PARENT_FOUND, arm_nwk_nd_address_read(interface_id, &nd_address) == 0);
+        if (!mesh_timeline_phase_seen(MESH_PHASE_RPL_JOINED)) {
+            probe_phase(MESH_PHASE_RPL_JOINED, rpl_parent_selected());
+        }
+        probed = PROBED_PHASES_ND;
+    }
+    probe_phase(MESH_PHASE_ADDRESS_REGISTERED,
+                arm_net_address_get(interface_id, ADDR_IPV6_GP, address) == 0);
+
+    return (phases_seen & probed) != probed;
+}
+
+int mesh_timeline_read(mesh_bootstrap_event_t *events, int count)
+{
+    int i;
+
+    for (i = 0; i < count && i < timeline_count; i++) {
+        events[i] = timeline[(timeline_head + i) % MESH_TIMELINE_SIZE];
+    }
+    return i;
+}
+
+const char *mesh_timeline_phase_name(uint8_t phase)
+{
+    if (phase >= sizeof(phase_names) / sizeof(phase_names[0])) {
+        return "unknown";
+    }
+    return phase_names[phase];
+}
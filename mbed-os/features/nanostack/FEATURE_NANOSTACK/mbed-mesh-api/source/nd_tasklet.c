@@ -22,6 +22,7 @@
 #include "nsdynmemLIB.h"
 #include "include/nd_tasklet.h"
 #include "include/mesh_system.h"
+#include "include/mesh_timeline.h"
 #include "ns_event_loop.h"
 #include "multicast_api.h"
 
@@ -37,6 +38,7 @@
 
 // Tasklet timer events
 #define TIMER_EVENT_START_BOOTSTRAP   1
+#define TIMER_EVENT_PROBE_PHASES      2
 
 #define INVALID_INTERFACE_ID        (-1)
 
@@ -59,6 +61,8 @@ typedef enum {
  */
 typedef struct {
     void (*mesh_api_cb)(mesh_connection_status_t nwk_status);
+    bool probe_pending;
+    bool address_notified;
     channel_list_s channel_list;
     tasklet_state_t tasklet_state;
     net_6lowpan_mode_e mode;
@@ -78,6 +82,7 @@ void nd_tasklet_main(arm_event_s *event);
 void nd_tasklet_network_state_changed(mesh_connection_status_t status);
 void nd_tasklet_parse_network_event(arm_event_s *event);
 void nd_tasklet_configure_and_connect_to_network(void);
+static void nd_tasklet_probe_phases(void);
 #define TRACE_ND_TASKLET
 #ifndef TRACE_ND_TASKLET
 #define nd_tasklet_trace_bootstrap_info() ((void) 0)
@@ -144,6 +149,8 @@ void nd_tasklet_main(arm_event_s *event)
             if (event->event_id == TIMER_EVENT_START_BOOTSTRAP) {
                 tr_debug("Restart bootstrap");
                 nd_tasklet_configure_and_connect_to_network();
+            } else if (event->event_id == TIMER_EVENT_PROBE_PHASES) {
+                nd_tasklet_probe_phases();
             }
             break;
 
@@ -180,7 +187,9 @@ void nd_tasklet_parse_network_event(arm_event_s *event)
                 tr_info("6LoWPAN ND bootstrap ready");
                 tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_READY;
                 nd_tasklet_trace_bootstrap_info();
+                mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_READY);
                 nd_tasklet_network_state_changed(MESH_CONNECTED);
+                nd_tasklet_probe_phases();
             }
             break;
         case ARM_NWK_NWK_SCAN_FAIL:
@@ -211,6 +220,7 @@ void nd_tasklet_parse_network_event(arm_event_s *event)
     }
 
     if (tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_READY) {
+        mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_FAILED);
         // Set 5s timer for new network scan
         eventOS_event_timer_request(TIMER_EVENT_START_BOOTSTRAP,
                                     ARM_LIB_SYSTEM_TIMER_EVENT,
@@ -276,6 +286,8 @@ void nd_tasklet_configure_and_connect_to_network(void)
     status = arm_nwk_interface_up(tasklet_data_ptr->network_interface_id);
     if (status >= 0) {
         tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_STARTED;
+        mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_START);
+        nd_tasklet_probe_phases();
         tr_info("Start 6LoWPAN ND Bootstrap");
     } else {
         tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_FAILED;
@@ -284,6 +296,44 @@ void nd_tasklet_configure_and_connect_to_network(void)
     }
 }
 
+/*
+ * Record the bootstrap phases reached so far and tell the application when
+ * the global address is available. Nanostack does not report the phases,
+ * so they are probed until all have been reached, or until the bootstrap
+ * is ready and the address has been reported.
+ */
+static void nd_tasklet_probe_phases(void)
+{
+    bool more;
+
+    tasklet_data_ptr->probe_pending = false;
+    if (tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_STARTED &&
+            tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_READY) {
+        return;
+    }
+
+    more = mesh_timeline_probe(tasklet_data_ptr->network_interface_id, MESH_TYPE_6LOWPAN_ND);
+
+    if (tasklet_data_ptr->tasklet_state == TASKLET_STATE_BOOTSTRAP_READY &&
+            !tasklet_data_ptr->address_notified &&
+            mesh_timeline_phase_seen(MESH_PHASE_ADDRESS_REGISTERED)) {
+        tasklet_data_ptr->address_notified = true;
+        nd_tasklet_network_state_changed(MESH_GLOBAL_ADDRESS_READY);
+    }
+    /* A phase still missing then, like the RPL join of a node without a primary parent, is not waited for */
+    if (tasklet_data_ptr->tasklet_state == TASKLET_STATE_BOOTSTRAP_READY && tasklet_data_ptr->address_notified) {
+        more = false;
+    }
+
+    if (more && !tasklet_data_ptr->probe_pending) {
+        tasklet_data_ptr->probe_pending = true;
+        eventOS_event_timer_request(TIMER_EVENT_PROBE_PHASES,
+                                    ARM_LIB_SYSTEM_TIMER_EVENT,
+                                    tasklet_data_ptr->node_main_tasklet_id,
+                                    MBED_CONF_MBED_MESH_API_BOOTSTRAP_PROBE_INTERVAL);
+    }
+}
+
 /*
  * Inform application about network state change
  */
@@ -377,6 +427,7 @@ int8_t nd_tasklet_connect(mesh_interface_cb callback, int8_t nwk_interface_id)
 
     memset(tasklet_data_ptr, 0, sizeof(tasklet_data_str_t));
     tasklet_data_ptr->mesh_api_cb = callback;
+    mesh_timeline_start();
     tasklet_data_ptr->network_interface_id = nwk_interface_id;
     tasklet_data_ptr->tasklet_state = TASKLET_STATE_INITIALIZED;
 
@@ -407,6 +458,8 @@ int8_t nd_tasklet_disconnect(bool send_cb)
     if (tasklet_data_ptr != NULL) {
         if (tasklet_data_ptr->network_interface_id != INVALID_INTERFACE_ID) {
             status = arm_nwk_interface_down(tasklet_data_ptr->network_interface_id);
+            eventOS_event_timer_cancel(TIMER_EVENT_PROBE_PHASES, tasklet_data_ptr->node_main_tasklet_id);
+            tasklet_data_ptr->probe_pending = false;
             tasklet_data_ptr->network_interface_id = INVALID_INTERFACE_ID;
             if (send_cb == true) {
                 nd_tasklet_network_state_changed(MESH_DISCONNECTED);
@@ -24,6 +24,7 @@
 #include "net_polling_api.h"
 #include "include/thread_tasklet.h"
 #include "include/mesh_system.h"
+#include "include/mesh_timeline.h"
 #include <mbed_assert.h>
 #include "ns_event_loop.h"
 
@@ -46,6 +47,7 @@
 
 // Tasklet timer events
 #define TIMER_EVENT_START_BOOTSTRAP   1
+#define TIMER_EVENT_PROBE_PHASES      2
 
 #define INVALID_INTERFACE_ID        (-1)
 
@@ -65,6 +67,8 @@ typedef enum {
  */
 typedef struct {
     void (*mesh_api_cb)(mesh_connection_status_t nwk_status);
+    bool probe_pending;
+    bool address_notified;
     channel_list_s channel_list;
     tasklet_state_t tasklet_state;
     int8_t tasklet;
@@ -88,6 +92,7 @@ void thread_tasklet_main(arm_event_s *event);
 void thread_tasklet_network_state_changed(mesh_connection_status_t status);
 void thread_tasklet_parse_network_event(arm_event_s *event);
 void thread_tasklet_configure_and_connect_to_network(void);
+static void thread_tasklet_probe_phases(void);
 #define TRACE_THREAD_TASKLET
 #ifndef TRACE_THREAD_TASKLET
 #define thread_tasklet_trace_bootstrap_info() ((void) 0)
@@ -128,7 +133,13 @@ void thread_tasklet_main(arm_event_s *event)
 
             if (event->event_id == TIMER_EVENT_START_BOOTSTRAP) {
                 tr_debug("Restart bootstrap");
-                arm_nwk_interface_up(thread_tasklet_data_ptr->nwk_if_id);
+                if (arm_nwk_interface_up(thread_tasklet_data_ptr->nwk_if_id) >= 0) {
+                    thread_tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_STARTED;
+                    mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_START);
+                    thread_tasklet_probe_phases();
+                }
+            } else if (event->event_id == TIMER_EVENT_PROBE_PHASES) {
+                thread_tasklet_probe_phases();
             }
             break;
 
@@ -165,7 +176,9 @@ void thread_tasklet_parse_network_event(arm_event_s *event)
                 tr_info("Thread bootstrap ready");
                 thread_tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_READY;
                 thread_tasklet_trace_bootstrap_info();
+                mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_READY);
                 thread_tasklet_network_state_changed(MESH_CONNECTED);
+                thread_tasklet_probe_phases();
             }
             break;
         case ARM_NWK_NWK_SCAN_FAIL:
@@ -196,6 +209,7 @@ void thread_tasklet_parse_network_event(arm_event_s *event)
     }
 
     if (thread_tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_READY) {
+        mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_FAILED);
         // Set 5s timer for a new network scan
         eventOS_event_timer_request(TIMER_EVENT_START_BOOTSTRAP,
                                     ARM_LIB_SYSTEM_TIMER_EVENT,
@@ -300,6 +314,8 @@ void thread_tasklet_configure_and_connect_to_network(void)
 
     if (status >= 0) {
         thread_tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_STARTED;
+        mesh_timeline_mark(MESH_PHASE_BOOTSTRAP_START);
+        thread_tasklet_probe_phases();
         tr_info("Start Thread bootstrap (%s mode)", thread_tasklet_data_ptr->operating_mode == NET_6LOWPAN_SLEEPY_HOST ? "SED" : "Router");
     } else {
         thread_tasklet_data_ptr->tasklet_state = TASKLET_STATE_BOOTSTRAP_FAILED;
@@ -308,6 +324,44 @@ void thread_tasklet_configure_and_connect_to_network(void)
     }
 }
 
+/*
+ * Record the bootstrap phases reached so far and tell the application when
+ * the global address is available. Nanostack does not report the phases,
+ * so they are probed until all have been reached, or until the bootstrap
+ * is ready and the address has been reported.
+ */
+static void thread_tasklet_probe_phases(void)
+{
+    bool more;
+
+    thread_tasklet_data_ptr->probe_pending = false;
+    if (thread_tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_STARTED &&
+            thread_tasklet_data_ptr->tasklet_state != TASKLET_STATE_BOOTSTRAP_READY) {
+        return;
+    }
+
+    more = mesh_timeline_probe(thread_tasklet_data_ptr->nwk_if_id, MESH_TYPE_THREAD);
+
+    if (thread_tasklet_data_ptr->tasklet_state == TASKLET_STATE_BOOTSTRAP_READY &&
+            !thread_tasklet_data_ptr->address_notified &&
+            mesh_timeline_phase_seen(MESH_PHASE_ADDRESS_REGISTERED)) {
+        thread_tasklet_data_ptr->address_notified = true;
+        thread_tasklet_network_state_changed(MESH_GLOBAL_ADDRESS_READY);
+    }
+    /* A phase still missing then, like the RPL join of a node without a primary parent, is not waited for */
+    if (thread_tasklet_data_ptr->tasklet_state == TASKLET_STATE_BOOTSTRAP_READY && thread_tasklet_data_ptr->address_notified) {
+        more = false;
+    }
+
+    if (more && !thread_tasklet_data_ptr->probe_pending) {
+        thread_tasklet_data_ptr->probe_pending = true;
+        eventOS_event_timer_request(TIMER_EVENT_PROBE_PHASES,
+                                    ARM_LIB_SYSTEM_TIMER_EVENT,
+                                    thread_tasklet_data_ptr->tasklet,
+                                    MBED_CONF_MBED_MESH_API_BOOTSTRAP_PROBE_INTERVAL);
+    }
+}
+
 /*
  * Inform application about network state change
  */
@@ -375,6 +429,7 @@ int8_t thread_tasklet_connect(mesh_interface_cb callback, int8_t nwk_interface_i
 
     memset(thread_tasklet_data_ptr, 0, sizeof(thread_tasklet_data_str_t));
     thread_tasklet_data_ptr->mesh_api_cb = callback;
+    mesh_timeline_start();
     thread_tasklet_data_ptr->nwk_if_id = nwk_interface_id;
     thread_tasklet_data_ptr->tasklet_state = TASKLET_STATE_INITIALIZED;
 
@@ -402,6 +457,8 @@ int8_t thread_tasklet_disconnect(bool send_cb)
     if (thread_tasklet_data_ptr != NULL) {
         if (thread_tasklet_data_ptr->nwk_if_id != INVALID_INTERFACE_ID) {
             status = arm_nwk_interface_down(thread_tasklet_data_ptr->nwk_if_id);
+            eventOS_event_timer_cancel(TIMER_EVENT_PROBE_PHASES, thread_tasklet_data_ptr->tasklet);
+            thread_tasklet_data_ptr->probe_pending = false;
             thread_tasklet_data_ptr->nwk_if_id = INVALID_INTERFACE_ID;
             if (send_cb == true) {
                 thread_tasklet_network_state_changed(MESH_DISCONNECTED);
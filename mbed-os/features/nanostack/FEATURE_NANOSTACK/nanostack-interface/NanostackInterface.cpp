@@ -18,6 +18,7 @@
 #include "rtos.h"
 #include "NanostackInterface.h"
 #include "NanostackLockGuard.h"
+#include "NanostackRfPhy.h"
 
 #include "ns_address.h"
 #include "nsdynmemLIB.h"
@@ -28,13 +29,29 @@
 #include "mesh_system.h" // from inside mbed-mesh-api
 #include "socket_api.h"
 #include "net_interface.h"
+#include "nwk_stats_api.h"
 
 // Uncomment to enable trace
 //#define HAVE_DEBUG
 #include "ns_trace.h"
 #define TRACE_GROUP "nsif"
 
-#define NS_INTERFACE_SOCKETS_MAX  16  //same as NanoStack SOCKET_MAX
+// The Nanostack library refuses sockets above its own limit, 16 unless rebuilt
+#define NS_INTERFACE_SOCKETS_MAX  MBED_CONF_NANOSTACK_INTERFACE_SOCKET_MAX
+#define NS_INTERFACE_SOCKETS_INIT MBED_CONF_NANOSTACK_INTERFACE_SOCKET_TABLE_INITIAL
+#if NS_INTERFACE_SOCKETS_INIT < 1
+#error "nanostack-interface.socket-table-initial must be at least 1, the socket table grows by doubling"
+#endif
+#if NS_INTERFACE_SOCKETS_MAX < 1 || NS_INTERFACE_SOCKETS_MAX > 127
+#error "nanostack-interface.socket-max must be 1..127, Nanostack socket IDs are int8_t"
+#endif
+#define NS_INTERFACE_IOV_MAX      8   //buffers per sendmsg/recvmsg
+#define NS_INTERFACE_RX_INFO_QUEUE 8  //link qualities and times kept for queued datagrams
+#define NS_INTERFACE_TX_STAMP_QUEUE 8 //unread transmit completions
+#define NS_INTERFACE_TX_DESTS      4  //destinations with pending datagrams counted per socket
+#define NS_INTERFACE_TX_DEST_QUEUE 16 //pending datagrams whose destination is kept
+#define NS_INTERFACE_TX_DEST_NONE  0xff
+#define NS_INTERFACE_TCP_WINDOW_MAX 0xffff //no window scaling in Nanostack TCP
 
 #define MALLOC  ns_dyn_mem_alloc
 #define FREE    ns_dyn_mem_free
@@ -55,6 +72,12 @@ enum socket_mode_t {
 };
 
 
+// Link layer information of a received datagram
+struct ns_rx_info_t {
+    uint8_t lqi;
+    uint32_t timestamp;         /*!< us ticker, valid if timestamping was enabled */
+};
+
 class NanostackSocket {
 public:
     static void socket_callback(void *cb);
@@ -87,18 +110,114 @@ public:
     // Run callback to signal the next layer of the NSAPI
     void signal_event(void);
 
+    // Link quality and time of the datagram that is read next
+    bool pop_rx_info(ns_rx_info_t *rx_info);
+
+    // Transmit completion times for NSAPI_TXTIMESTAMP
+    void push_tx_stamp(nsapi_error_t result);
+    bool pop_tx_stamp(nsapi_txtimestamp_t *stamp);
+    bool timestamping;          /*!< NSAPI_TIMESTAMP enabled */
+    uint16_t rx_done_seen;      /*!< tag of the last radio RX time used */
+    uint16_t tx_done_seen;      /*!< tag of the last radio TX time used */
+
+    // Event callback of socket_notify()
+    void set_notify(uint32_t mask, void (*callback)(void *, uint32_t, nsapi_error_t), void *data);
+    void notify(uint32_t events, nsapi_error_t reason);
+    // A call returned would block, signal the events again
+    void drained(uint32_t events);
+
+    // SOCKET_SO_SNDBUF or SOCKET_SO_RCVBUF in bytes
+    bool set_buffer(int optname, int32_t size);
+
+    // Datagram transmit accounting for NSAPI_TXQUEUE, NSAPI_TXQUEUE_DEST and NSAPI_TXLOWAT
+    void tx_queued(const ns_address_t *dest);
+    void tx_completed(void);
+    uint16_t tx_dest_pending(const ns_address_t *dest, uint16_t *untracked);
+    uint16_t tx_pending;        /*!< datagrams sent and not yet done or failed */
+    uint16_t tx_lowat;          /*!< writable is signalled at or below this many pending */
+
     void (*callback)(void *);
     void *callback_data;
     int8_t socket_id;           /*!< allocated socket ID */
     int8_t proto;               /*!< UDP or TCP */
     bool addr_valid;
+    bool recv_hop_limit;        /*!< SOCKET_IPV6_RECVHOPLIMIT enabled */
+    bool recv_pktinfo;          /*!< SOCKET_IPV6_RECVPKTINFO enabled */
     ns_address_t ns_address;
 private:
     bool attach(int8_t socket_id);
     socket_mode_t mode;
+    // Nanostack reports the link quality only in the data event, so it is
+    // queued with the receive time until the datagram is read
+    ns_rx_info_t rx_info_queue[NS_INTERFACE_RX_INFO_QUEUE];
+    uint8_t rx_info_head;
+    uint8_t rx_info_count;
+    uint8_t rx_info_untracked;  /*!< queued datagrams beyond rx_info_queue */
+    nsapi_txtimestamp_t tx_stamp_queue[NS_INTERFACE_TX_STAMP_QUEUE];
+    uint8_t tx_stamp_head;
+    uint8_t tx_stamp_count;
+    // Nanostack does not say which datagram a TX done is for, so pending
+    // datagrams are matched to their destinations in send order
+    struct tx_dest_t {
+        uint8_t address[16];
+        uint16_t port;
+        uint16_t pending;
+    } tx_dests[NS_INTERFACE_TX_DESTS];
+    uint8_t tx_dest_queue[NS_INTERFACE_TX_DEST_QUEUE]; /*!< index to tx_dests per pending datagram */
+    uint8_t tx_dest_head;
+    uint8_t tx_dest_count;
+    uint16_t tx_dest_untracked; /*!< pending datagrams beyond tx_dest_queue */
+    void (*notify_callback)(void *, uint32_t, nsapi_error_t);
+    void *notify_data;
+    uint32_t notify_mask;
+    uint32_t notify_pending;    /*!< readable/writable signalled but not drained */
 };
 
-static NanostackSocket * socket_tbl[NS_INTERFACE_SOCKETS_MAX];
+// Indexed by Nanostack socket ID, grown on demand up to NS_INTERFACE_SOCKETS_MAX
+static NanostackSocket ** socket_tbl;
+static int socket_tbl_size;
+
+static NanostackSocket *socket_tbl_get(int8_t socket_id)
+{
+    if (socket_id < 0 || socket_id >= socket_tbl_size) {
+        return NULL;
+    }
+    return socket_tbl[socket_id];
+}
+
+static bool socket_tbl_reserve(int8_t socket_id)
+{
+    nanostack_assert_locked();
+
+    if (socket_id < 0 || socket_id >= NS_INTERFACE_SOCKETS_MAX) {
+        return false;
+    }
+    if (socket_id < socket_tbl_size) {
+        return true;
+    }
+
+    int size = socket_tbl_size ? socket_tbl_size : NS_INTERFACE_SOCKETS_INIT;
+    while (size <= socket_id) {
+        size *= 2;
+    }
+    if (size > NS_INTERFACE_SOCKETS_MAX) {
+        size = NS_INTERFACE_SOCKETS_MAX;
+    }
+
+    NanostackSocket **tbl = static_cast<NanostackSocket **>(MALLOC(size * sizeof *tbl));
+    if (tbl == NULL) {
+        return false;
+    }
+    memset(tbl, 0, size * sizeof *tbl);
+    if (socket_tbl != NULL) {
+        memcpy(tbl, socket_tbl, socket_tbl_size * sizeof *tbl);
+        FREE(socket_tbl);
+    }
+    socket_tbl = tbl;
+    socket_tbl_size = size;
+    tr_debug("socket table grown to %d entries", size);
+    return true;
+}
 
 nsapi_error_t map_mesh_error(mesh_error_t err)
 {
@@ -141,8 +260,28 @@ NanostackSocket::NanostackSocket(int8_t protocol)
     socket_id = -1;
     proto = protocol;
     addr_valid = false;
+    recv_hop_limit = false;
+    recv_pktinfo = false;
     memset(&ns_address, 0, sizeof(ns_address));
     mode = SOCKET_MODE_UNOPENED;
+    rx_info_head = 0;
+    rx_info_count = 0;
+    rx_info_untracked = 0;
+    tx_stamp_head = 0;
+    tx_stamp_count = 0;
+    memset(tx_dests, 0, sizeof tx_dests);
+    tx_dest_head = 0;
+    tx_dest_count = 0;
+    tx_dest_untracked = 0;
+    timestamping = false;
+    rx_done_seen = 0;
+    tx_done_seen = 0;
+    notify_callback = NULL;
+    notify_data = NULL;
+    notify_mask = 0;
+    notify_pending = 0;
+    tx_pending = 0;
+    tx_lowat = 0;
 }
 
 NanostackSocket::~NanostackSocket()
@@ -175,7 +314,21 @@ bool NanostackSocket::open(void)
         mode = SOCKET_MODE_DATAGRAM;
     }
 
-    return attach(temp_socket);
+    if (!attach(temp_socket)) {
+        socket_close(temp_socket);
+        mode = SOCKET_MODE_UNOPENED;
+        return false;
+    }
+
+    if (proto == SOCKET_TCP) {
+        if (MBED_CONF_NANOSTACK_INTERFACE_TCP_SNDBUF) {
+            set_buffer(SOCKET_SO_SNDBUF, MBED_CONF_NANOSTACK_INTERFACE_TCP_SNDBUF);
+        }
+        if (MBED_CONF_NANOSTACK_INTERFACE_TCP_RCVBUF) {
+            set_buffer(SOCKET_SO_RCVBUF, MBED_CONF_NANOSTACK_INTERFACE_TCP_RCVBUF);
+        }
+    }
+    return true;
 }
 
 int NanostackSocket::accept(NanostackSocket *accepted_socket, ns_address_t *addr)
@@ -189,6 +342,7 @@ int NanostackSocket::accept(NanostackSocket *accepted_socket, ns_address_t *addr
         return temp_socket;
     }
     if (!accepted_socket->attach(temp_socket)) {
+        socket_close(temp_socket);
         return -1;
     }
     accepted_socket->mode = SOCKET_MODE_STREAM;
@@ -198,8 +352,8 @@ int NanostackSocket::accept(NanostackSocket *accepted_socket, ns_address_t *addr
 bool NanostackSocket::attach(int8_t temp_socket)
 {
     nanostack_assert_locked();
-    if (temp_socket >= NS_INTERFACE_SOCKETS_MAX) {
-        MBED_ASSERT(false);
+    if (!socket_tbl_reserve(temp_socket)) {
+        tr_error("NanostackSocket::attach() no room for socket %d", temp_socket);
         return false;
     }
     if (socket_tbl[temp_socket] != NULL) {
@@ -227,6 +381,8 @@ void NanostackSocket::close()
     }
 
     mode = SOCKET_MODE_CLOSED;
+    // Let the next read or write report the closed socket
+    notify(NSAPI_SOCKET_EVENT_READABLE | NSAPI_SOCKET_EVENT_WRITABLE, NSAPI_ERROR_OK);
     signal_event();
 }
 
@@ -279,11 +435,184 @@ void NanostackSocket::signal_event()
     }
 }
 
+void NanostackSocket::set_notify(uint32_t mask, void (*callback)(void *, uint32_t, nsapi_error_t), void *data)
+{
+    nanostack_assert_locked();
+
+    notify_callback = callback;
+    notify_data = data;
+    notify_mask = callback ? mask : 0;
+    notify_pending = 0;
+}
+
+void NanostackSocket::notify(uint32_t events, nsapi_error_t reason)
+{
+    nanostack_assert_locked();
+
+    events &= notify_mask;
+    // Readable and writable are not repeated until the socket is drained,
+    // so a burst of datagrams wakes the application up once
+    uint32_t level = NSAPI_SOCKET_EVENT_READABLE | NSAPI_SOCKET_EVENT_WRITABLE;
+    events &= ~(notify_pending & level);
+    notify_pending |= events & level;
+
+    if (events && notify_callback != NULL) {
+        notify_callback(notify_data, events, reason);
+    }
+}
+
+void NanostackSocket::drained(uint32_t events)
+{
+    nanostack_assert_locked();
+
+    notify_pending &= ~events;
+}
+
+void NanostackSocket::tx_queued(const ns_address_t *dest)
+{
+    nanostack_assert_locked();
+
+    if (mode != SOCKET_MODE_DATAGRAM) {
+        return;
+    }
+    if (tx_pending < 0xffff) {
+        tx_pending++;
+    }
+
+    uint8_t index = NS_INTERFACE_TX_DEST_NONE;
+    for (uint8_t i = 0; i < NS_INTERFACE_TX_DESTS; i++) {
+        tx_dest_t *d = &tx_dests[i];
+        if (d->pending && d->port == dest->identifier && memcmp(d->address, dest->address, 16) == 0) {
+            index = i;
+            break;
+        }
+        if (!d->pending && index == NS_INTERFACE_TX_DEST_NONE) {
+            // Free entry, unless the destination turns up later on
+            index = i;
+        }
+    }
+    if (tx_dest_count == NS_INTERFACE_TX_DEST_QUEUE || tx_dest_untracked) {
+        // Completions of older datagrams come first, keep the order
+        index = NS_INTERFACE_TX_DEST_NONE;
+    }
+    if (index == NS_INTERFACE_TX_DEST_NONE) {
+        if (tx_dest_untracked < 0xffff) {
+            tx_dest_untracked++;
+        }
+    } else {
+        tx_dest_t *d = &tx_dests[index];
+        if (!d->pending) {
+            memcpy(d->address, dest->address, 16);
+            d->port = dest->identifier;
+        }
+        d->pending++;
+        tx_dest_queue[(tx_dest_head + tx_dest_count) % NS_INTERFACE_TX_DEST_QUEUE] = index;
+        tx_dest_count++;
+    }
+    // Above the low watermark writable has to be signalled again when the
+    // queue drains, even though no send would have blocked
+    if (tx_lowat && tx_pending > tx_lowat) {
+        drained(NSAPI_SOCKET_EVENT_WRITABLE);
+    }
+}
+
+void NanostackSocket::tx_completed()
+{
+    nanostack_assert_locked();
+
+    if (tx_pending) {
+        tx_pending--;
+    }
+    if (tx_dest_count) {
+        tx_dests[tx_dest_queue[tx_dest_head]].pending--;
+        tx_dest_head = (tx_dest_head + 1) % NS_INTERFACE_TX_DEST_QUEUE;
+        tx_dest_count--;
+    } else if (tx_dest_untracked) {
+        tx_dest_untracked--;
+    }
+}
+
+uint16_t NanostackSocket::tx_dest_pending(const ns_address_t *dest, uint16_t *untracked)
+{
+    nanostack_assert_locked();
+
+    *untracked = tx_dest_untracked;
+    for (uint8_t i = 0; i < NS_INTERFACE_TX_DESTS; i++) {
+        const tx_dest_t *d = &tx_dests[i];
+        if (d->pending && d->port == dest->identifier && memcmp(d->address, dest->address, 16) == 0) {
+            return d->pending;
+        }
+    }
+    return 0;
+}
+
+bool NanostackSocket::set_buffer(int optname, int32_t size)
+{
+    nanostack_assert_locked();
+
+    // The receive buffer is the advertised window, beyond 64k it is
+    // only wasted heap
+    if (proto == SOCKET_TCP && optname == SOCKET_SO_RCVBUF && size > NS_INTERFACE_TCP_WINDOW_MAX) {
+        size = NS_INTERFACE_TCP_WINDOW_MAX;
+    }
+    return ::socket_setsockopt(socket_id, SOCKET_SOL_SOCKET, optname, &size, sizeof size) == 0;
+}
+
+bool NanostackSocket::pop_rx_info(ns_rx_info_t *rx_info)
+{
+    nanostack_assert_locked();
+
+    if (rx_info_count) {
+        *rx_info = rx_info_queue[rx_info_head];
+        rx_info_head = (rx_info_head + 1) % NS_INTERFACE_RX_INFO_QUEUE;
+        rx_info_count--;
+        return true;
+    }
+    if (rx_info_untracked) {
+        rx_info_untracked--;
+    }
+    return false;
+}
+
+void NanostackSocket::push_tx_stamp(nsapi_error_t result)
+{
+    nanostack_assert_locked();
+
+    uint32_t timestamp;
+    if (!NanostackRfPhy::last_tx_done(&timestamp, &tx_done_seen)) {
+        // Driver does not record the time, or this socket already used it
+        // for an earlier completion: the stack reported it just now
+        timestamp = us_ticker_read();
+    }
+    if (tx_stamp_count == NS_INTERFACE_TX_STAMP_QUEUE) {
+        // Oldest unread one is dropped
+        tx_stamp_head = (tx_stamp_head + 1) % NS_INTERFACE_TX_STAMP_QUEUE;
+        tx_stamp_count--;
+    }
+    nsapi_txtimestamp_t *stamp = &tx_stamp_queue[(tx_stamp_head + tx_stamp_count) % NS_INTERFACE_TX_STAMP_QUEUE];
+    stamp->timestamp = timestamp;
+    stamp->result = result;
+    tx_stamp_count++;
+}
+
+bool NanostackSocket::pop_tx_stamp(nsapi_txtimestamp_t *stamp)
+{
+    nanostack_assert_locked();
+
+    if (!tx_stamp_count) {
+        return false;
+    }
+    *stamp = tx_stamp_queue[tx_stamp_head];
+    tx_stamp_head = (tx_stamp_head + 1) % NS_INTERFACE_TX_STAMP_QUEUE;
+    tx_stamp_count--;
+    return true;
+}
+
 void NanostackSocket::socket_callback(void *cb) {
     nanostack_assert_locked();
 
     socket_callback_t *sock_cb = (socket_callback_t *) cb;
-    NanostackSocket *socket = socket_tbl[sock_cb->socket_id];
+    NanostackSocket *socket = socket_tbl_get(sock_cb->socket_id);
     MBED_ASSERT(socket != NULL);
 
     tr_debug("socket_callback() sock=%d, event=%d, interface=%d, data len=%d",
@@ -347,6 +676,25 @@ void NanostackSocket::event_data(socket_callback_t *sock_cb)
     MBED_ASSERT((SOCKET_MODE_STREAM == mode) ||
                 (SOCKET_MODE_DATAGRAM == mode));
 
+    if (mode == SOCKET_MODE_DATAGRAM) {
+        if (rx_info_count < NS_INTERFACE_RX_INFO_QUEUE && !rx_info_untracked) {
+            ns_rx_info_t *rx_info = &rx_info_queue[(rx_info_head + rx_info_count) % NS_INTERFACE_RX_INFO_QUEUE];
+            rx_info->lqi = sock_cb->LINK_LQI;
+            // The radio time of the last frame received, or the delivery
+            // time if the driver does not record it or the frame's time was
+            // already used for an earlier datagram of this socket
+            if (!timestamping) {
+                rx_info->timestamp = 0;
+            } else if (!NanostackRfPhy::last_rx_done(&rx_info->timestamp, &rx_done_seen)) {
+                rx_info->timestamp = us_ticker_read();
+            }
+            rx_info_count++;
+        } else if (rx_info_untracked < 0xff) {
+            rx_info_untracked++;
+        }
+    }
+
+    notify(NSAPI_SOCKET_EVENT_READABLE, NSAPI_ERROR_OK);
     signal_event();
 }
 
@@ -356,12 +704,21 @@ void NanostackSocket::event_tx_done(socket_callback_t *sock_cb)
     MBED_ASSERT((SOCKET_MODE_STREAM == mode) ||
                 (SOCKET_MODE_DATAGRAM == mode));
 
+    uint32_t events = NSAPI_SOCKET_EVENT_TX_DONE | NSAPI_SOCKET_EVENT_WRITABLE;
     if (mode == SOCKET_MODE_DATAGRAM) {
         tr_debug("SOCKET_TX_DONE, %d bytes sent", sock_cb->d_len);
+        tx_completed();
+        if (tx_lowat && tx_pending > tx_lowat) {
+            events &= ~NSAPI_SOCKET_EVENT_WRITABLE;
+        }
+        if (timestamping) {
+            push_tx_stamp(NSAPI_ERROR_OK);
+        }
     } else if (mode == SOCKET_MODE_STREAM) {
         tr_debug("SOCKET_TX_DONE, %d bytes remaining", sock_cb->d_len);
     }
 
+    notify(events, NSAPI_ERROR_OK);
     signal_event();
 }
 
@@ -371,6 +728,7 @@ void NanostackSocket::event_connect_done(socket_callback_t *sock_cb)
     MBED_ASSERT(SOCKET_MODE_CONNECTING == mode);
 
     set_connected();
+    notify(NSAPI_SOCKET_EVENT_WRITABLE, NSAPI_ERROR_OK);
     signal_event();
 }
 
@@ -385,6 +743,7 @@ void NanostackSocket::event_incoming_connection(socket_callback_t *sock_cb)
 {
     nanostack_assert_locked();
     MBED_ASSERT(mode == SOCKET_MODE_LISTENING);
+    notify(NSAPI_SOCKET_EVENT_READABLE, NSAPI_ERROR_OK);
     signal_event();
 }
 
@@ -402,6 +761,30 @@ void NanostackSocket::event_tx_fail(socket_callback_t *sock_cb)
 {
     nanostack_assert_locked();
 
+    nsapi_error_t reason;
+    switch (sock_cb->event_type) {
+        case SOCKET_NO_ROUTE:
+            reason = NSAPI_ERROR_NO_ADDRESS;
+            break;
+        case SOCKET_NO_RAM:
+            reason = NSAPI_ERROR_NO_MEMORY;
+            break;
+        default:
+            reason = NSAPI_ERROR_DEVICE_ERROR;
+            break;
+    }
+    uint32_t events = NSAPI_SOCKET_EVENT_TX_FAIL;
+    if (mode == SOCKET_MODE_DATAGRAM) {
+        tx_completed();
+        if (!tx_lowat || tx_pending <= tx_lowat) {
+            events |= NSAPI_SOCKET_EVENT_WRITABLE;
+        }
+        if (timestamping) {
+            push_tx_stamp(reason);
+        }
+    }
+    notify(events, reason);
+
     switch (mode) {
         case SOCKET_MODE_CONNECTING:
         case SOCKET_MODE_STREAM:
@@ -429,17 +812,29 @@ void NanostackSocket::event_connection_reset(socket_callback_t *sock_cb)
 
 NanostackInterface *NanostackInterface::_ns_interface;
 
+// Nanostack updates one registered statistics buffer
+static nwk_stats_t nwk_stats;
+
 NanostackInterface *NanostackInterface::get_stack()
 {
     NanostackLockGuard lock;
 
     if (NULL == _ns_interface) {
         _ns_interface = new NanostackInterface();
+        memset(&nwk_stats, 0, sizeof nwk_stats);
+        protocol_stats_start(&nwk_stats);
     }
 
     return _ns_interface;
 }
 
+void NanostackInterface::get_nwk_stats(nwk_stats_t *stats)
+{
+    NanostackLockGuard lock;
+
+    *stats = nwk_stats;
+}
+
 const char * NanostackInterface::get_ip_address()
 {
     NanostackLockGuard lock;
@@ -512,6 +907,15 @@ nsapi_error_t NanostackInterface::socket_close(void *handle)
 }
 
 nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_address_t *address, const void *data, nsapi_size_t size)
+{
+    ns_iovec_t iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = size;
+
+    return do_sendmsg(handle, address, &iov, 1, NULL, 0);
+}
+
+nsapi_size_or_error_t NanostackInterface::do_sendmsg(void *handle, const ns_address_t *address, ns_iovec_t *iov, unsigned iovcnt, void *control, unsigned controllen)
 {
     // Validate parameters
     NanostackSocket * socket = static_cast<NanostackSocket *>(handle);
@@ -536,27 +940,19 @@ nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_addre
     }
 
     int retcode;
-#if 0
-    retcode = ::socket_sendto(socket->socket_id, address,
-                                            data, size);
-#else
-    // Use sendmsg purely to get the new return style
+    // Use sendmsg also for plain sends to get the new return style
     // of returning data written rather than 0 on success,
     // which means TCP can do partial writes. (Sadly,
     // it's the only call which takes flags so we can
     // leave the NS_MSG_LEGACY0 flag clear).
     ns_msghdr_t msg;
-    ns_iovec_t iov;
-    iov.iov_base = const_cast<void *>(data);
-    iov.iov_len = size;
     msg.msg_name = const_cast<ns_address_t *>(address);
     msg.msg_namelen = address ? sizeof *address : 0;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = NULL;
-    msg.msg_controllen = 0;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    msg.msg_control = control;
+    msg.msg_controllen = controllen;
     retcode = ::socket_sendmsg(socket->socket_id, &msg, 0);
-#endif
 
     /*
      * \return length if entire amount written (which could be 0)
@@ -570,11 +966,13 @@ nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_addre
      * \return -6 Packet too short (ICMP raw socket error).
      * */
     if (retcode == NS_EWOULDBLOCK) {
+        socket->drained(NSAPI_SOCKET_EVENT_WRITABLE);
         ret = NSAPI_ERROR_WOULD_BLOCK;
     } else if (retcode < 0) {
         tr_error("socket_sendmsg: error=%d", retcode);
         ret = NSAPI_ERROR_DEVICE_ERROR;
     } else {
+        socket->tx_queued(address ? address : &socket->ns_address);
         ret = retcode;
     }
 
@@ -620,6 +1018,7 @@ nsapi_size_or_error_t NanostackInterface::socket_recvfrom(void *handle, SocketAd
     retcode = ::socket_recvfrom(socket->socket_id, buffer, size, 0, &ns_address);
 
     if (retcode == NS_EWOULDBLOCK) {
+        socket->drained(NSAPI_SOCKET_EVENT_READABLE);
         ret = NSAPI_ERROR_WOULD_BLOCK;
     } else if (retcode < 0) {
         ret = NSAPI_ERROR_PARAMETER;
@@ -628,6 +1027,10 @@ nsapi_size_or_error_t NanostackInterface::socket_recvfrom(void *handle, SocketAd
         if (address != NULL) {
             convert_ns_addr_to_mbed(address, &ns_address);
         }
+        if (socket->proto == SOCKET_UDP) {
+            ns_rx_info_t rx_info;
+            socket->pop_rx_info(&rx_info);
+        }
     }
 
 out:
@@ -641,6 +1044,327 @@ out:
     return ret;
 }
 
+static bool convert_iov_to_ns(ns_iovec_t *ns_iov, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (iovcnt > NS_INTERFACE_IOV_MAX) {
+        return false;
+    }
+    for (unsigned i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0xffff) {
+            return false;
+        }
+        ns_iov[i].iov_base = iov[i].iov_base;
+        ns_iov[i].iov_len = iov[i].iov_len;
+    }
+    return true;
+}
+
+// Aligned room for a hop limit and a packet info control message
+union ns_msg_control {
+    long align;
+    uint8_t data[NS_CMSG_SPACE(sizeof(int16_t)) + NS_CMSG_SPACE(sizeof(ns_in6_pktinfo_t))];
+};
+
+nsapi_size_or_error_t NanostackInterface::socket_sendmsg(void *handle, const SocketAddress &address, const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info)
+{
+    if (address.get_ip_version() != NSAPI_IPv6) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+    // Only the hop limit and the source address can be applied to a send
+    if (info && (info->flags & ~(NSAPI_MSGINFO_HOP_LIMIT | NSAPI_MSGINFO_PKTINFO))) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+    if (info && (info->flags & NSAPI_MSGINFO_PKTINFO) &&
+            info->local_addr.version != NSAPI_IPv6 && info->local_addr.version != NSAPI_UNSPEC) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    ns_iovec_t ns_iov[NS_INTERFACE_IOV_MAX];
+    if (!convert_iov_to_ns(ns_iov, iov, iovcnt)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    ns_msg_control control;
+    unsigned controllen = 0;
+    if (info && info->flags) {
+        memset(control.data, 0, sizeof control.data);
+
+        ns_cmsghdr_t *cmsg = (ns_cmsghdr_t *)control.data;
+        if (info->flags & NSAPI_MSGINFO_HOP_LIMIT) {
+            cmsg->cmsg_level = SOCKET_IPPROTO_IPV6;
+            cmsg->cmsg_type = SOCKET_IPV6_HOPLIMIT;
+            cmsg->cmsg_len = NS_CMSG_LEN(sizeof(int16_t));
+            memcpy(NS_CMSG_DATA(cmsg), &info->hop_limit, sizeof(int16_t));
+            controllen += NS_CMSG_SPACE(sizeof(int16_t));
+            cmsg = (ns_cmsghdr_t *)(control.data + controllen);
+        }
+        if (info->flags & NSAPI_MSGINFO_PKTINFO) {
+            ns_in6_pktinfo_t pktinfo;
+            if (info->local_addr.version == NSAPI_IPv6) {
+                memcpy(pktinfo.ipi6_addr, info->local_addr.bytes, 16);
+            } else {
+                memcpy(pktinfo.ipi6_addr, ns_in6addr_any, 16);
+            }
+            pktinfo.ipi6_ifindex = info->interface_id;
+            cmsg->cmsg_level = SOCKET_IPPROTO_IPV6;
+            cmsg->cmsg_type = SOCKET_IPV6_PKTINFO;
+            cmsg->cmsg_len = NS_CMSG_LEN(sizeof pktinfo);
+            memcpy(NS_CMSG_DATA(cmsg), &pktinfo, sizeof pktinfo);
+            controllen += NS_CMSG_SPACE(sizeof pktinfo);
+        }
+    }
+
+    ns_address_t ns_address;
+    convert_mbed_addr_to_ns(&ns_address, &address);
+    /*No lock gaurd needed here as do_sendmsg() will handle locks.*/
+    return do_sendmsg(handle, &ns_address, ns_iov, iovcnt, controllen ? control.data : NULL, controllen);
+}
+
+// Ancillary data is enabled on the socket the first time it is requested
+static void enable_recv_info(NanostackSocket *socket, uint32_t requested)
+{
+    static const bool enable = true;
+
+    if ((requested & NSAPI_MSGINFO_HOP_LIMIT) && !socket->recv_hop_limit) {
+        ::socket_setsockopt(socket->socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_RECVHOPLIMIT, &enable, sizeof enable);
+        socket->recv_hop_limit = true;
+    }
+    if ((requested & NSAPI_MSGINFO_PKTINFO) && !socket->recv_pktinfo) {
+        ::socket_setsockopt(socket->socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_RECVPKTINFO, &enable, sizeof enable);
+        socket->recv_pktinfo = true;
+    }
+}
+
+// Read one datagram, info->flags is only overwritten if one was read
+static nsapi_size_or_error_t do_recvmsg(NanostackSocket *socket, ns_address_t *ns_address, ns_iovec_t *ns_iov, unsigned iovcnt, nsapi_msginfo_t *info)
+{
+    nanostack_assert_locked();
+
+    ns_msg_control control;
+    ns_msghdr_t msg;
+    msg.msg_name = ns_address;
+    msg.msg_namelen = sizeof *ns_address;
+    msg.msg_iov = ns_iov;
+    msg.msg_iovlen = iovcnt;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof control.data;
+    msg.msg_flags = 0;
+
+    int retcode;
+    retcode = ::socket_recvmsg(socket->socket_id, &msg, 0);
+
+    if (retcode == NS_EWOULDBLOCK) {
+        socket->drained(NSAPI_SOCKET_EVENT_READABLE);
+        return NSAPI_ERROR_WOULD_BLOCK;
+    } else if (retcode < 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    ns_rx_info_t rx_info;
+    bool rx_info_valid = socket->proto == SOCKET_UDP && socket->pop_rx_info(&rx_info);
+    if (info) {
+        uint32_t requested = info->flags;
+        info->flags = 0;
+        for (ns_cmsghdr_t *cmsg = NS_CMSG_FIRSTHDR(&msg); cmsg; cmsg = NS_CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOCKET_IPPROTO_IPV6) {
+                continue;
+            }
+            if (cmsg->cmsg_type == SOCKET_IPV6_HOPLIMIT && (requested & NSAPI_MSGINFO_HOP_LIMIT)) {
+                memcpy(&info->hop_limit, NS_CMSG_DATA(cmsg), sizeof(int16_t));
+                info->flags |= NSAPI_MSGINFO_HOP_LIMIT;
+            } else if (cmsg->cmsg_type == SOCKET_IPV6_PKTINFO && (requested & NSAPI_MSGINFO_PKTINFO)) {
+                ns_in6_pktinfo_t pktinfo;
+                memcpy(&pktinfo, NS_CMSG_DATA(cmsg), sizeof pktinfo);
+                info->local_addr.version = NSAPI_IPv6;
+                memcpy(info->local_addr.bytes, pktinfo.ipi6_addr, 16);
+                info->interface_id = pktinfo.ipi6_ifindex;
+                info->flags |= NSAPI_MSGINFO_PKTINFO;
+            }
+        }
+        if (rx_info_valid && (requested & NSAPI_MSGINFO_LINK_QUALITY)) {
+            info->link_quality = rx_info.lqi;
+            info->flags |= NSAPI_MSGINFO_LINK_QUALITY;
+        }
+        if (rx_info_valid && socket->timestamping && (requested & NSAPI_MSGINFO_TIMESTAMP)) {
+            info->timestamp = rx_info.timestamp;
+            info->flags |= NSAPI_MSGINFO_TIMESTAMP;
+        }
+        if (msg.msg_flags & NS_MSG_TRUNC) {
+            info->flags |= NSAPI_MSGINFO_TRUNCATED;
+        }
+    }
+
+    return retcode;
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_recvmsg(void *handle, SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info)
+{
+    // Validate parameters
+    NanostackSocket *socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    ns_iovec_t ns_iov[NS_INTERFACE_IOV_MAX];
+    if (!convert_iov_to_ns(ns_iov, iov, iovcnt)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    nsapi_size_or_error_t ret;
+
+    NanostackLockGuard lock;
+
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+        goto out;
+    }
+
+    if (info) {
+        enable_recv_info(socket, info->flags);
+    }
+
+    ns_address_t ns_address;
+    ret = do_recvmsg(socket, &ns_address, ns_iov, iovcnt, info);
+    if (ret >= 0 && address != NULL) {
+        convert_ns_addr_to_mbed(address, &ns_address);
+    }
+
+out:
+    tr_debug("socket_recvmsg(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_recvmmsg(void *handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    // Validate parameters
+    NanostackSocket *socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    nsapi_size_or_error_t ret;
+    unsigned received = 0;
+
+    // One lock for the whole batch instead of one per datagram
+    NanostackLockGuard lock;
+
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+        goto out;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        enable_recv_info(socket, msgs[i].info.flags);
+    }
+
+    ret = 0;
+    while (received < count) {
+        nsapi_mmsg_t *msg = &msgs[received];
+        if (msg->size > 0xffff) {
+            ret = NSAPI_ERROR_PARAMETER;
+            break;
+        }
+
+        ns_iovec_t ns_iov;
+        ns_iov.iov_base = msg->buffer;
+        ns_iov.iov_len = msg->size;
+        ns_address_t ns_address;
+        ret = do_recvmsg(socket, &ns_address, &ns_iov, 1, &msg->info);
+        if (ret < 0) {
+            break;
+        }
+        msg->length = ret;
+        msg->addr.version = NSAPI_IPv6;
+        memcpy(msg->addr.bytes, ns_address.address, 16);
+        msg->port = ns_address.identifier;
+        received++;
+    }
+    if (received) {
+        ret = received;
+    }
+
+out:
+    tr_debug("socket_recvmmsg(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_recv_borrow(void *handle, SocketAddress *address, const void **data)
+{
+    // Validate parameters
+    NanostackSocket *socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    if (socket->proto != SOCKET_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    nsapi_size_or_error_t ret;
+    int16_t length;
+    uint8_t peek;
+    uint8_t *buffer;
+    ns_address_t ns_address;
+
+    NanostackLockGuard lock;
+
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+        goto out;
+    }
+
+    // Nanostack does not hand out its own buffers, so the datagram is copied
+    // into an allocated block of its exact size
+    length = ::socket_recvfrom(socket->socket_id, &peek, sizeof peek, NS_MSG_PEEK | NS_MSG_TRUNC, NULL);
+    if (length == NS_EWOULDBLOCK) {
+        socket->drained(NSAPI_SOCKET_EVENT_READABLE);
+        ret = NSAPI_ERROR_WOULD_BLOCK;
+        goto out;
+    } else if (length < 0) {
+        ret = NSAPI_ERROR_PARAMETER;
+        goto out;
+    }
+
+    // Copies are short lived, keep them away from the long term allocations
+    buffer = (uint8_t *)ns_dyn_mem_temporary_alloc(length + 1);
+    if (!buffer) {
+        ret = NSAPI_ERROR_NO_MEMORY;
+        goto out;
+    }
+
+    length = ::socket_recvfrom(socket->socket_id, buffer, length, 0, &ns_address);
+    if (length < 0) {
+        FREE(buffer);
+        ret = NSAPI_ERROR_PARAMETER;
+        goto out;
+    }
+    buffer[length] = '\0';
+    ns_rx_info_t rx_info;
+    socket->pop_rx_info(&rx_info);
+    if (address != NULL) {
+        convert_ns_addr_to_mbed(address, &ns_address);
+    }
+    *data = buffer;
+    ret = length;
+
+out:
+    tr_debug("socket_recv_borrow(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
+}
+
+void NanostackInterface::socket_recv_release(void *handle, const void *data)
+{
+    (void)handle;
+    NanostackLockGuard lock;
+
+    FREE(const_cast<void *>(data));
+}
+
 nsapi_error_t NanostackInterface::socket_bind(void *handle, const SocketAddress &address)
 {
     // Validate parameters
@@ -694,6 +1418,44 @@ nsapi_error_t NanostackInterface::setsockopt(void *handle, int level, int optnam
 
     NanostackLockGuard lock;
 
+    if (level == NSAPI_SOCKET && optname == NSAPI_TXLOWAT) {
+        if (optlen != sizeof(int) || *(const int *)optval < 0 || *(const int *)optval > 0xffff) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        socket->tx_lowat = *(const int *)optval;
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && (optname == NSAPI_SNDBUF || optname == NSAPI_RCVBUF)) {
+        if (optlen != sizeof(int) || *(const int *)optval < 0) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        if (!socket->set_buffer(optname == NSAPI_SNDBUF ? SOCKET_SO_SNDBUF : SOCKET_SO_RCVBUF, *(const int *)optval)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_NODELAY) {
+        // Nanostack does not expose control of segment coalescing
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_TIMESTAMP) {
+        if (optlen != sizeof(int)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        bool enable = *(const int *)optval != 0;
+        if (enable && !socket->timestamping) {
+            // Radio times recorded before now belong to earlier frames
+            uint32_t timestamp;
+            NanostackRfPhy::last_rx_done(&timestamp, &socket->rx_done_seen);
+            NanostackRfPhy::last_tx_done(&timestamp, &socket->tx_done_seen);
+        }
+        socket->timestamping = enable;
+        return NSAPI_ERROR_OK;
+    }
+
     if (::socket_setsockopt(socket->socket_id, level, optname, optval, optlen) == 0) {
         ret = NSAPI_ERROR_OK;
     } else {
@@ -715,6 +1477,72 @@ nsapi_error_t NanostackInterface::getsockopt(void *handle, int level, int optnam
 
     NanostackLockGuard lock;
 
+    if (level == NSAPI_SOCKET && optname == NSAPI_TXQUEUE) {
+        if (*optlen < sizeof(nsapi_txqueue_t)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        nsapi_txqueue_t *txqueue = static_cast<nsapi_txqueue_t *>(optval);
+        txqueue->socket_pending = socket->tx_pending;
+        txqueue->socket_lowat = socket->tx_lowat;
+        txqueue->link_queue = nwk_stats.mac_tx_queue_size;
+        txqueue->link_queue_peak = nwk_stats.mac_tx_queue_peak;
+        txqueue->link_overflow = nwk_stats.mac_tx_buffer_overflow;
+        *optlen = sizeof(nsapi_txqueue_t);
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_TXQUEUE_DEST) {
+        if (*optlen < sizeof(nsapi_txdest_t)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        nsapi_txdest_t *txdest = static_cast<nsapi_txdest_t *>(optval);
+        SocketAddress address(txdest->addr, txdest->port);
+        ns_address_t dest;
+        convert_mbed_addr_to_ns(&dest, &address);
+        txdest->pending = socket->tx_dest_pending(&dest, &txdest->untracked);
+        *optlen = sizeof(nsapi_txdest_t);
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && (optname == NSAPI_SNDBUF || optname == NSAPI_RCVBUF)) {
+        int32_t size;
+        uint16_t size_len = sizeof size;
+        if (*optlen < sizeof(int)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        if (::socket_getsockopt(socket->socket_id, SOCKET_SOL_SOCKET,
+                optname == NSAPI_SNDBUF ? SOCKET_SO_SNDBUF : SOCKET_SO_RCVBUF, &size, &size_len) != 0) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        *(int *)optval = size;
+        *optlen = sizeof(int);
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_NODELAY) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_TIMESTAMP) {
+        if (*optlen < sizeof(int)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        *(int *)optval = socket->timestamping;
+        *optlen = sizeof(int);
+        return NSAPI_ERROR_OK;
+    }
+
+    if (level == NSAPI_SOCKET && optname == NSAPI_TXTIMESTAMP) {
+        if (*optlen < sizeof(nsapi_txtimestamp_t)) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+        if (!socket->pop_tx_stamp(static_cast<nsapi_txtimestamp_t *>(optval))) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+        *optlen = sizeof(nsapi_txtimestamp_t);
+        return NSAPI_ERROR_OK;
+    }
+
     uint16_t optlen16 = *optlen;
     if (::socket_getsockopt(socket->socket_id, level, optname, optval, &optlen16) == 0) {
         ret = NSAPI_ERROR_OK;
@@ -830,6 +1658,7 @@ nsapi_error_t NanostackInterface::socket_accept(void *server, void **handle, Soc
     if (retcode < 0) {
         delete accepted_sock;
         if (retcode == NS_EWOULDBLOCK) {
+            socket->drained(NSAPI_SOCKET_EVENT_READABLE);
             ret = NSAPI_ERROR_WOULD_BLOCK;
         } else {
             ret = NSAPI_ERROR_DEVICE_ERROR;
@@ -876,3 +1705,21 @@ void NanostackInterface::socket_attach(void *handle, void (*callback)(void *), v
 
     tr_debug("socket_attach(socket=%p) sock_id=%d", socket, socket->socket_id);
 }
+
+nsapi_error_t NanostackInterface::socket_notify(void *handle, uint32_t mask, void (*callback)(void *, uint32_t, nsapi_error_t), void *data)
+{
+    // Validate parameters
+    NanostackSocket * socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    NanostackLockGuard lock;
+
+    socket->set_notify(mask, callback, data);
+
+    tr_debug("socket_notify(socket=%p) sock_id=%d, mask=%x", socket, socket->socket_id, (unsigned)mask);
+
+    return NSAPI_ERROR_OK;
+}
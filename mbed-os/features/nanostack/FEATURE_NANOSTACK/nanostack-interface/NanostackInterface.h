@@ -27,11 +27,22 @@
 #include "MeshInterfaceNanostack.h"
 
 struct ns_address;
+struct nwk_stats_t;
 
 class NanostackInterface : public NetworkStack {
 public:
     static NanostackInterface *get_stack();
 
+    /** Copy the network statistics
+     *
+     *  Nanostack updates a single statistics buffer, which is registered
+     *  by the interface, so applications read it from here instead of
+     *  starting their own with protocol_stats_start().
+     *
+     *  @param stats    Destination for the statistics
+     */
+    static void get_nwk_stats(struct nwk_stats_t *stats);
+
 protected:
 
     /** Get the local IP address
@@ -185,6 +196,75 @@ protected:
      */
     virtual nsapi_size_or_error_t socket_recvfrom(void *handle, SocketAddress *address, void *buffer, nsapi_size_t size);
 
+    /** Send a packet gathered from several buffers over a UDP socket
+     *
+     *  Passes the buffers and the hop limit and packet info ancillary
+     *  data straight to Nanostack's socket_sendmsg().
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host
+     *  @param iov      Buffers of data to send to the host, at most 8
+     *  @param iovcnt   Number of buffers
+     *  @param info     Ancillary data to apply, or NULL
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendmsg(void *handle, const SocketAddress &address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info);
+
+    /** Receive a packet scattered into several buffers over a UDP socket
+     *
+     *  Reads the datagram with Nanostack's socket_recvmsg(). Hop limit and
+     *  packet info are enabled on the socket the first time they are
+     *  requested, so datagrams queued before may come without them. The
+     *  link quality is the LQI the radio reported for the last hop.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Destination buffers for data received from the host, at most 8
+     *  @param iovcnt   Number of buffers
+     *  @param info     Requested ancillary data and its destination, or NULL
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmsg(void *handle, SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info);
+
+    /** Receive several packets over a UDP socket
+     *
+     *  Reads the queued datagrams into the slots while holding the
+     *  Nanostack lock once, instead of once per datagram.
+     *
+     *  @param handle   Socket handle
+     *  @param msgs     Slots to receive the datagrams into
+     *  @param count    Number of slots
+     *  @return         Number of received datagrams on success, negative
+     *                  error code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmmsg(void *handle, nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a packet over a UDP socket into an allocated copy
+     *
+     *  Nanostack keeps its own buffers private, so this is not zero-copy:
+     *  the datagram length is peeked, a temporary heap block of that size
+     *  is allocated and the datagram is copied into it. The block is freed
+     *  by socket_recv_release.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for the pointer to the received data
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recv_borrow(void *handle, SocketAddress *address, const void **data);
+
+    /** Free a buffer allocated by socket_recv_borrow
+     *
+     *  @param handle   Socket handle
+     *  @param data     Data pointer returned by socket_recv_borrow
+     */
+    virtual void socket_recv_release(void *handle, const void *data);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
@@ -200,12 +280,37 @@ protected:
      */
     virtual void socket_attach(void *handle, void (*callback)(void *), void *data);
 
+    /** Register a callback for selected events of the socket
+     *
+     *  The events are derived from the Nanostack socket callback. The TX
+     *  fail reason is NSAPI_ERROR_NO_ADDRESS for SOCKET_NO_ROUTE,
+     *  NSAPI_ERROR_NO_MEMORY for SOCKET_NO_RAM and NSAPI_ERROR_DEVICE_ERROR
+     *  for SOCKET_TX_FAIL. The callback runs in the Nanostack event thread
+     *  with the stack locked.
+     *
+     *  @param handle   Socket handle
+     *  @param mask     Combination of nsapi_socket_event_t to signal
+     *  @param callback Function to call with the events and the TX fail reason
+     *  @param data     Argument to pass to callback
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t socket_notify(void *handle, uint32_t mask,
+            void (*callback)(void *, uint32_t, nsapi_error_t), void *data);
+
     /*  Set stack-specific socket options
      *
      *  The setsockopt allow an application to pass stack-specific hints
      *  to the underlying stack. For unsupported options,
      *  NSAPI_ERROR_UNSUPPORTED is returned and the socket is unmodified.
      *
+     *  At level NSAPI_SOCKET, NSAPI_SNDBUF and NSAPI_RCVBUF take the buffer
+     *  size in bytes as int and map to SOCKET_SO_SNDBUF and SOCKET_SO_RCVBUF.
+     *  For TCP the receive buffer is the advertised window, which Nanostack
+     *  does not scale, so it is limited to 65535. Set them before connect()
+     *  to size the first window; nanostack-interface.tcp-sndbuf and
+     *  tcp-rcvbuf give the defaults of new TCP sockets. NSAPI_NODELAY is
+     *  not supported, Nanostack has no control over segment coalescing.
+     *
      *  @param handle   Socket handle
      *  @param level    Stack-specific protocol level
      *  @param optname  Stack-specific option identifier
@@ -232,6 +337,7 @@ protected:
 
 private:
     nsapi_size_or_error_t do_sendto(void *handle, const struct ns_address *address, const void *data, nsapi_size_t size);
+    nsapi_size_or_error_t do_sendmsg(void *handle, const struct ns_address *address, struct ns_iovec *iov, unsigned iovcnt, void *control, unsigned controllen);
     char text_ip_address[40];
     static NanostackInterface * _ns_interface;
 };
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "NanostackRfPhy.h"
+
+// Written from the driver interrupt, read from the Nanostack event thread.
+// The count tags each stamp, so a reader can tell a new one from one it
+// has already used.
+static volatile uint32_t rx_done_time;
+static volatile uint16_t rx_done_count;
+static volatile uint32_t tx_done_time;
+static volatile uint16_t tx_done_count;
+
+void NanostackRfPhy::timestamp_rx_done()
+{
+    rx_done_time = us_ticker_read();
+    rx_done_count++;
+}
+
+void NanostackRfPhy::timestamp_tx_done()
+{
+    tx_done_time = us_ticker_read();
+    tx_done_count++;
+}
+
+bool NanostackRfPhy::last_rx_done(uint32_t *timestamp, uint16_t *seen)
+{
+    core_util_critical_section_enter();
+    bool fresh = rx_done_count != *seen;
+    *timestamp = rx_done_time;
+    *seen = rx_done_count;
+    core_util_critical_section_exit();
+    return fresh;
+}
+
+bool NanostackRfPhy::last_tx_done(uint32_t *timestamp, uint16_t *seen)
+{
+    core_util_critical_section_enter();
+    bool fresh = tx_done_count != *seen;
+    *timestamp = tx_done_time;
+    *seen = tx_done_count;
+    core_util_critical_section_exit();
+    return fresh;
+}
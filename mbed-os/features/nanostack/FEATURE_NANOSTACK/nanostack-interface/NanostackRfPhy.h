@@ -33,6 +33,44 @@ public:
      *
      */
     virtual void unregister() { rf_unregister(); }
+
+    /** Record the time a frame was received
+     *
+     *  Drivers call this from their RX done interrupt, before passing the
+     *  frame to Nanostack, so that sockets with NSAPI_TIMESTAMP get the
+     *  radio time instead of the time the stack delivered the datagram.
+     *
+     *  Only the most recent time is kept, for all frames of all radios.
+     *  Nanostack does not say which frame a datagram came from, so a
+     *  socket gets the time of the last frame received before the
+     *  datagram was delivered. That is approximate: an acknowledgement,
+     *  a forwarded frame or a datagram of another socket in between
+     *  replaces it.
+     */
+    static void timestamp_rx_done();
+
+    /** Record the time a transmission completed, from the TX done interrupt
+     *
+     *  Approximate in the same way as timestamp_rx_done: a socket's TX
+     *  done gets the time of the last transmission of any frame.
+     */
+    static void timestamp_tx_done();
+
+    /** Fetch the last recorded RX done time
+     *
+     *  @param timestamp    us ticker time of the frame
+     *  @param seen         Tag of the time the caller used last, updated
+     *  @return             true if a time was recorded since seen
+     */
+    static bool last_rx_done(uint32_t *timestamp, uint16_t *seen);
+
+    /** Fetch the last recorded TX done time
+     *
+     *  @param timestamp    us ticker time of the completion
+     *  @param seen         Tag of the time the caller used last, updated
+     *  @return             true if a time was recorded since seen
+     */
+    static bool last_tx_done(uint32_t *timestamp, uint16_t *seen);
 };
 
 #endif /* NANOSTACK_RF_PHY_H_ */
@@ -753,6 +753,7 @@ static void rf_rx_interrupt() {
         lqi = rf_mac_convert_rssi(MAC_RSSI_TO_LQI);
         rssi = rf_mac_get_rssi();
         rf_mac_rx_enable();
+        NanostackRfPhy::timestamp_rx_done();
         //Call ARM API
         if( device_driver.phy_rx_cb ){
             device_driver.phy_rx_cb(PHYPAYLOAD, length, lqi, rssi, rf_radio_driver_id);
@@ -794,6 +795,7 @@ static void rf_mac_tx_interrupt(void)
         break;
     }
     rf_mac_ack_requsted = false;
+    NanostackRfPhy::timestamp_tx_done();
      //Call RX TX complete
     if( device_driver.phy_tx_done_cb ) {
         device_driver.phy_tx_done_cb(rf_radio_driver_id, rf_mac_handle, status, 1, 1);
@@ -70,6 +70,70 @@ nsapi_error_t NetworkStack::getsockopt(void *handle, int level, int optname, voi
     return NSAPI_ERROR_UNSUPPORTED;
 }
 
+nsapi_size_or_error_t NetworkStack::socket_sendmsg(nsapi_socket_t handle, const SocketAddress &address,
+        const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info)
+{
+    if (iovcnt != 1 || (info && info->flags)) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    return socket_sendto(handle, address, iov[0].iov_base, iov[0].iov_len);
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvmsg(nsapi_socket_t handle, SocketAddress *address,
+        const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info)
+{
+    if (iovcnt != 1 || (info && info->flags)) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    return socket_recvfrom(handle, address, iov[0].iov_base, iov[0].iov_len);
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvmmsg(nsapi_socket_t handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    unsigned received = 0;
+
+    while (received < count) {
+        nsapi_mmsg_t *msg = &msgs[received];
+        nsapi_iovec_t iov = { msg->buffer, msg->size };
+        SocketAddress address;
+        // Unused slots keep the requested flags
+        uint32_t requested = msg->info.flags;
+
+        nsapi_size_or_error_t ret = socket_recvmsg(handle, &address, &iov, 1, &msg->info);
+        if (ret < 0) {
+            msg->info.flags = requested;
+            if (received == 0) {
+                return ret;
+            }
+            break;
+        }
+        msg->length = ret;
+        msg->addr = address.get_addr();
+        msg->port = address.get_port();
+        received++;
+    }
+
+    return received;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recv_borrow(nsapi_socket_t handle, SocketAddress *address,
+        const void **data)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+void NetworkStack::socket_recv_release(nsapi_socket_t handle, const void *data)
+{
+}
+
+nsapi_error_t NetworkStack::socket_notify(nsapi_socket_t handle, uint32_t mask,
+        void (*callback)(void *, uint32_t, nsapi_error_t), void *data)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
 
 // NetworkStackWrapper class for encapsulating the raw nsapi_stack structure
 class NetworkStackWrapper : public NetworkStack
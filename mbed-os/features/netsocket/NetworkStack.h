@@ -253,6 +253,126 @@ protected:
     virtual nsapi_size_or_error_t socket_recvfrom(nsapi_socket_t handle, SocketAddress *address,
             void *buffer, nsapi_size_t size) = 0;
 
+    /** Send a packet gathered from several buffers over a UDP socket
+     *
+     *  Sends the concatenated buffers as one datagram to the specified
+     *  address, with the ancillary data in info applied. Returns the number
+     *  of bytes sent. Flags in info that cannot be applied to a send
+     *  return NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  The default implementation supports a single buffer without
+     *  ancillary data on top of socket_sendto.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host
+     *  @param iov      Buffers of data to send to the host
+     *  @param iovcnt   Number of buffers
+     *  @param info     Ancillary data to apply, or NULL
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendmsg(nsapi_socket_t handle, const SocketAddress &address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info);
+
+    /** Receive a packet scattered into several buffers over a UDP socket
+     *
+     *  Receives one datagram into the buffers in order and stores the
+     *  source address in address if address is not NULL. The ancillary
+     *  data requested in info->flags is returned in info, with flags set
+     *  to the fields that were filled in. Returns the number of bytes
+     *  received.
+     *
+     *  The default implementation supports a single buffer without
+     *  ancillary data on top of socket_recvfrom.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Destination buffers for data received from the host
+     *  @param iovcnt   Number of buffers
+     *  @param info     Requested ancillary data and its destination, or NULL
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmsg(nsapi_socket_t handle, SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info);
+
+    /** Receive several packets over a UDP socket
+     *
+     *  Receives up to count datagrams, one into each slot, until the
+     *  socket has no more data queued. Returns the number of slots filled.
+     *  An error after the first datagram ends the batch early and is
+     *  reported by the next call.
+     *
+     *  The default implementation calls socket_recvmsg for each slot.
+     *
+     *  This call is non-blocking. If no datagram is queued,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param msgs     Slots to receive the datagrams into
+     *  @param count    Number of slots
+     *  @return         Number of received datagrams on success, negative
+     *                  error code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmmsg(nsapi_socket_t handle, nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a packet over a UDP socket into a buffer provided by the stack
+     *
+     *  Receives one datagram and points data at a buffer provided by the
+     *  stack that holds it, followed by a terminating zero byte. A stack
+     *  may lend its own packet buffer or allocate a copy. The buffer stays
+     *  valid until it is passed to socket_recv_release. Returns the length
+     *  of the datagram.
+     *
+     *  The default implementation returns NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  This call is non-blocking. If no datagram is queued,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for the pointer to the received data
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recv_borrow(nsapi_socket_t handle, SocketAddress *address,
+            const void **data);
+
+    /** Return a buffer from socket_recv_borrow to the stack
+     *
+     *  @param handle   Socket handle
+     *  @param data     Data pointer returned by socket_recv_borrow
+     */
+    virtual void socket_recv_release(nsapi_socket_t handle, const void *data);
+
+    /** Register a callback for selected events of the socket
+     *
+     *  Unlike socket_attach, the callback is told which events happened
+     *  and, for NSAPI_SOCKET_EVENT_TX_FAIL, why. Repeated readable and
+     *  writable events are coalesced until the socket is drained. An empty
+     *  mask or a NULL callback detaches it.
+     *
+     *  The callback may be called in an interrupt context and should not
+     *  perform expensive operations such as recv/send calls.
+     *
+     *  The default implementation returns NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  @param handle   Socket handle
+     *  @param mask     Combination of nsapi_socket_event_t to signal
+     *  @param callback Function to call with the events and the TX fail
+     *                  reason, NSAPI_ERROR_OK for other events
+     *  @param data     Argument to pass to callback
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t socket_notify(nsapi_socket_t handle, uint32_t mask,
+            void (*callback)(void *, uint32_t, nsapi_error_t), void *data);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
@@ -16,14 +16,103 @@
 
 #include "Socket.h"
 #include "mbed.h"
+#include "events/EventQueue.h"
+#include "platform/mbed_critical.h"
+#include "rtos/Thread.h"
+#include <new>
+
+/* Drain calls refer to this instead of the socket. It is freed by the
+ * socket when no drain call exists, or else by the last drain call. */
+struct Socket::ring_state {
+    SocketEventRing ring;
+    events::EventQueue *queue;
+    Socket *socket;             // 0 once detached from the socket
+    int event_id;               // last drain call posted
+    uint8_t scheduled;          // drain call posted and not started, atomic
+    uint8_t calls;              // drain calls not yet dispatched or cancelled
+    bool draining;              // notify callback running
+    osThreadId_t drain_thread;
+};
+
+/* The queue destroys its copy of the call when it has been dispatched or
+ * cancelled */
+class Socket::ring_drain_call {
+public:
+    ring_drain_call(ring_state *state) : _state(state)
+    {
+        core_util_atomic_incr_u8(&_state->calls, 1);
+    }
+
+    ring_drain_call(const ring_drain_call &other) : _state(other._state)
+    {
+        core_util_atomic_incr_u8(&_state->calls, 1);
+    }
+
+    ~ring_drain_call()
+    {
+        core_util_critical_section_enter();
+        bool last = --_state->calls == 0 && !_state->socket;
+        core_util_critical_section_exit();
+        if (last) {
+            delete _state;
+        }
+    }
+
+    void operator()()
+    {
+        Socket::ring_drain(_state);
+    }
+
+private:
+    ring_state *_state;
+};
 
 Socket::Socket()
     : _stack(0)
     , _socket(0)
     , _timeout(osWaitForever)
+    , _ring(0)
 {
 }
 
+Socket::~Socket()
+{
+    // The stack can no longer push, ring_event is detached by close()
+    ring_detach();
+}
+
+// Called with the ring detached from the stack
+void Socket::ring_detach()
+{
+    ring_state *state = _ring;
+    if (!state) {
+        return;
+    }
+    _ring = 0;
+
+    // Frees the drain call unless the queue has started it already
+    state->queue->cancel(state->event_id);
+
+    core_util_critical_section_enter();
+    state->socket = 0;
+    bool wait = state->draining && state->drain_thread != osThreadGetId();
+    bool last = state->calls == 0;
+    core_util_critical_section_exit();
+
+    // A drain already notifying on another thread must finish before the
+    // socket goes. Detached from within the callback, the drain stops after it.
+    while (wait) {
+        rtos::Thread::wait(1);
+        core_util_critical_section_enter();
+        wait = state->draining;
+        last = state->calls == 0;
+        core_util_critical_section_exit();
+    }
+    if (last) {
+        delete state;
+    }
+}
+
 nsapi_error_t Socket::open(NetworkStack *stack)
 {
     _lock.lock();
@@ -56,6 +145,8 @@ nsapi_error_t Socket::close()
     nsapi_error_t ret = NSAPI_ERROR_OK;
     if (_socket) {
         _stack->socket_attach(_socket, 0, 0);
+        _stack->socket_notify(_socket, 0, 0, 0);
+        ring_detach();
         nsapi_socket_t socket = _socket;
         _socket = 0;
         ret = _stack->socket_close(socket);
@@ -156,6 +247,107 @@ void Socket::sigio(Callback<void()> callback)
     _lock.unlock();
 }
 
+nsapi_error_t Socket::notify(uint32_t mask, Callback<void(uint32_t, nsapi_error_t)> func)
+{
+    _lock.lock();
+
+    nsapi_error_t ret = NSAPI_ERROR_NO_SOCKET;
+    if (_socket) {
+        _stack->socket_notify(_socket, 0, 0, 0);
+        ring_detach();
+        _notify = func;
+        if (!func) {
+            mask = 0;
+        }
+        ret = _stack->socket_notify(_socket, mask,
+                &Callback<void(uint32_t, nsapi_error_t)>::thunk, &_notify);
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_error_t Socket::notify(uint32_t mask, EventQueue *queue, Callback<void(uint32_t, nsapi_error_t)> func)
+{
+    if (!queue || !func || !mask) {
+        return notify(0, 0);
+    }
+
+    _lock.lock();
+
+    nsapi_error_t ret = NSAPI_ERROR_NO_SOCKET;
+    if (_socket) {
+        // Detach first, the stack thread must not push while the ring changes
+        _stack->socket_notify(_socket, 0, 0, 0);
+        if (_ring && _ring->queue != queue) {
+            // Drains already posted run on the old queue and find it detached
+            ring_detach();
+        }
+        if (!_ring) {
+            _ring = new (std::nothrow) ring_state;
+            if (_ring) {
+                _ring->queue = queue;
+                _ring->socket = this;
+                _ring->event_id = 0;
+                _ring->scheduled = 0;
+                _ring->calls = 0;
+                _ring->draining = false;
+                _ring->drain_thread = 0;
+            }
+        }
+        if (!_ring) {
+            ret = NSAPI_ERROR_NO_MEMORY;
+        } else {
+            _notify = func;
+            ret = _stack->socket_notify(_socket, mask, &Socket::ring_event, _ring);
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+void Socket::ring_event(void *data, uint32_t events, nsapi_error_t reason)
+{
+    // Network stack thread, must not block
+    ring_state *state = static_cast<ring_state *>(data);
+    state->ring.push(events, reason);
+
+    uint8_t idle = 0;
+    if (core_util_atomic_cas_u8(&state->scheduled, &idle, 1)) {
+        state->event_id = state->queue->call(ring_drain_call(state));
+        if (!state->event_id) {
+            // Queue full, the next event tries again
+            state->scheduled = 0;
+        }
+    }
+}
+
+void Socket::ring_drain(ring_state *state)
+{
+    // Events pushed from now on post a new drain
+    state->scheduled = 0;
+    __DMB();
+
+    uint32_t events;
+    nsapi_error_t reason;
+    while (state->ring.pop(&events, &reason)) {
+        core_util_critical_section_enter();
+        Socket *socket = state->socket;
+        state->draining = socket != 0;
+        state->drain_thread = osThreadGetId();
+        core_util_critical_section_exit();
+        if (!socket) {
+            break;
+        }
+        // May close or delete the socket
+        socket->_notify(events, reason);
+        core_util_critical_section_enter();
+        state->draining = false;
+        core_util_critical_section_exit();
+    }
+}
+
 void Socket::attach(Callback<void()> callback)
 {
     sigio(callback);
@@ -22,10 +22,14 @@
 
 #include "netsocket/SocketAddress.h"
 #include "netsocket/NetworkStack.h"
+#include "netsocket/SocketEventRing.h"
 #include "rtos/Mutex.h"
 #include "Callback.h"
 #include "mbed_toolchain.h"
 
+namespace events {
+class EventQueue;
+}
 
 /** Abstract socket class
  */
@@ -35,7 +39,7 @@ public:
      *
      *  Closes socket if the socket is still open
      */
-    virtual ~Socket() {}
+    virtual ~Socket();
 
     /** Opens a socket
      *
@@ -172,6 +176,55 @@ public:
      */
     void sigio(mbed::Callback<void()> func);
 
+    /** Register a callback for selected events of the socket
+     *
+     *  The callback is called with the events that happened, out of the
+     *  ones in mask, and with the reason of a NSAPI_SOCKET_EVENT_TX_FAIL.
+     *  Readable and writable are signalled once until the socket has been
+     *  drained with a receive or send that returned NSAPI_ERROR_WOULD_BLOCK,
+     *  so data arriving meanwhile does not cause more wakeups. The socket
+     *  must be open.
+     *
+     *  The callback may be called in an interrupt context and should not
+     *  perform expensive operations such as recv/send calls.
+     *
+     *  @param mask     Combination of nsapi_socket_event_t to signal,
+     *                  0 to detach the callback
+     *  @param func     Function to call with the events and the TX fail
+     *                  reason, NSAPI_ERROR_OK for other events
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED if the stack
+     *                  can only signal with sigio
+     */
+    nsapi_error_t notify(uint32_t mask, mbed::Callback<void(uint32_t, nsapi_error_t)> func);
+
+    /** Register a callback for selected events of the socket, run from an event queue
+     *
+     *  The network stack thread records the events in a ring of the socket
+     *  without locking or allocating, and posts to the queue only when no
+     *  drain call is pending. The callback is then called from the queue
+     *  once per recorded event, in order. A slow application thus never
+     *  blocks the stack thread, and a burst of events costs one post.
+     *
+     *  That post is a regular EventQueue::call: it allocates the call from
+     *  the queue's event buffer and takes the queue's critical section,
+     *  once per burst. If the buffer is full the events stay in the ring
+     *  and the next event of the socket posts again.
+     *
+     *  The callback may perform recv/send calls. Events that do not fit the
+     *  ring (nsapi.socket-event-ring-size) are merged into one call.
+     *
+     *  @param mask     Combination of nsapi_socket_event_t to signal,
+     *                  0 to detach the callback
+     *  @param queue    Event queue the callback is called from
+     *  @param func     Function to call with the events and the TX fail
+     *                  reason, NSAPI_ERROR_OK for other events
+     *  @return         0 on success, NSAPI_ERROR_NO_MEMORY if the ring could
+     *                  not be allocated, NSAPI_ERROR_UNSUPPORTED if the stack
+     *                  can only signal with sigio
+     */
+    nsapi_error_t notify(uint32_t mask, events::EventQueue *queue,
+            mbed::Callback<void(uint32_t, nsapi_error_t)> func);
+
     /** Register a callback on state change of the socket
      *
      *  @see Socket::sigio
@@ -204,11 +257,22 @@ protected:
     virtual nsapi_protocol_t get_proto() = 0;
     virtual void event() = 0;
 
+    // Event ring and the drain calls posted for it, outlive the socket if needed
+    struct ring_state;
+    class ring_drain_call;
+
+    // Producer and consumer side of the event ring
+    static void ring_event(void *data, uint32_t events, nsapi_error_t reason);
+    static void ring_drain(ring_state *state);
+    void ring_detach();
+
     NetworkStack *_stack;
     nsapi_socket_t _socket;
     uint32_t _timeout;
     mbed::Callback<void()> _event;
     mbed::Callback<void()> _callback;
+    mbed::Callback<void(uint32_t, nsapi_error_t)> _notify;
+    ring_state *_ring;
     rtos::Mutex _lock;
 };
 
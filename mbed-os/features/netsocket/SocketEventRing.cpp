@@ -0,0 +1,75 @@
+/* SocketEventRing
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SocketEventRing.h"
+#include "cmsis.h"
+#include "mbed_critical.h"
+
+SocketEventRing::SocketEventRing()
+    : _head(0)
+    , _tail(0)
+    , _overflow_events(0)
+    , _overflows(0)
+{
+}
+
+void SocketEventRing::push(uint32_t events, nsapi_error_t reason)
+{
+    uint16_t tail = _tail;
+    uint16_t next = (tail + 1) % SOCKET_EVENT_RING_SIZE;
+
+    if (next == _head) {
+        uint32_t merged = _overflow_events;
+        while (!core_util_atomic_cas_u32(&_overflow_events, &merged, merged | events));
+        _overflows++;
+        return;
+    }
+
+    _records[tail].events = events;
+    _records[tail].reason = reason;
+    // The record must be visible before the consumer sees the new tail
+    __DMB();
+    _tail = next;
+}
+
+bool SocketEventRing::pop(uint32_t *events, nsapi_error_t *reason)
+{
+    uint16_t head = _head;
+
+    if (head != _tail) {
+        __DMB();
+        *events = _records[head].events;
+        *reason = _records[head].reason;
+        // The record must be read before the producer may reuse it
+        __DMB();
+        _head = (head + 1) % SOCKET_EVENT_RING_SIZE;
+        return true;
+    }
+
+    uint32_t merged = _overflow_events;
+    if (!merged) {
+        return false;
+    }
+    while (!core_util_atomic_cas_u32(&_overflow_events, &merged, 0));
+    *events = merged;
+    *reason = (merged & NSAPI_SOCKET_EVENT_TX_FAIL) ? NSAPI_ERROR_DEVICE_ERROR : NSAPI_ERROR_OK;
+    return true;
+}
+
+uint32_t SocketEventRing::overflows() const
+{
+    return _overflows;
+}
@@ -0,0 +1,80 @@
+
+/** \addtogroup netsocket */
+/** @{*/
+/* SocketEventRing
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOCKET_EVENT_RING_H
+#define SOCKET_EVENT_RING_H
+
+#include "nsapi_types.h"
+
+#define SOCKET_EVENT_RING_SIZE MBED_CONF_NSAPI_SOCKET_EVENT_RING_SIZE
+
+#if SOCKET_EVENT_RING_SIZE < 2 || SOCKET_EVENT_RING_SIZE > UINT16_MAX
+#error "nsapi.socket-event-ring-size must be between 2 and 65535"
+#endif
+
+/** Single producer, single consumer ring of socket events
+ *
+ *  Hands the events of Socket::notify over from the network stack thread
+ *  to an application thread without locks or allocation. Only one thread
+ *  may push and only one thread may pop. Events that do not fit are
+ *  merged into one overflow record, so none is lost.
+ */
+class SocketEventRing {
+public:
+    SocketEventRing();
+
+    /** Add an event record, called by the producer only
+     *
+     *  @param events   Combination of nsapi_socket_event_t
+     *  @param reason   TX fail reason, NSAPI_ERROR_OK for other events
+     */
+    void push(uint32_t events, nsapi_error_t reason);
+
+    /** Remove the oldest event record, called by the consumer only
+     *
+     *  The overflow record comes last. The reason of a TX fail in it is
+     *  NSAPI_ERROR_DEVICE_ERROR, as the original reason is not kept.
+     *
+     *  @param events   Destination for the events
+     *  @param reason   Destination for the TX fail reason
+     *  @return         true if a record was removed
+     */
+    bool pop(uint32_t *events, nsapi_error_t *reason);
+
+    /** Number of pushes that were merged into the overflow record
+     */
+    uint32_t overflows() const;
+
+private:
+    struct record {
+        uint32_t events;
+        nsapi_error_t reason;
+    };
+
+    record _records[SOCKET_EVENT_RING_SIZE];
+    volatile uint16_t _head;        // written by the consumer
+    volatile uint16_t _tail;        // written by the producer
+    uint32_t _overflow_events;      // atomic, set by the producer, cleared by the consumer
+    volatile uint32_t _overflows;
+};
+
+
+#endif
+
+/** @}*/
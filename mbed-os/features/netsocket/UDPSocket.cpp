@@ -125,6 +125,170 @@ nsapi_size_or_error_t UDPSocket::recvfrom(SocketAddress *address, void *buffer,
     return ret;
 }
 
+nsapi_size_or_error_t UDPSocket::sendmsg(const SocketAddress &address, const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        nsapi_size_or_error_t sent = _stack->socket_sendmsg(_socket, address, iov, iovcnt, info);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != sent)) {
+            ret = sent;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(WRITE_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recvmsg(SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+    // Requested fields, the stack overwrites flags with the filled in ones
+    uint32_t requested = info ? info->flags : 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        if (info) {
+            info->flags = requested;
+        }
+        nsapi_size_or_error_t recv = _stack->socket_recvmsg(_socket, address, iov, iovcnt, info);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recvmmsg(nsapi_mmsg_t *msgs, unsigned count)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        nsapi_size_or_error_t recv = _stack->socket_recvmmsg(_socket, msgs, count);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recv_borrow(SocketAddress *address, const void **data)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        nsapi_size_or_error_t recv = _stack->socket_recv_borrow(_socket, address, data);
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+void UDPSocket::release(const void *data)
+{
+    _lock.lock();
+
+    if (_socket) {
+        _stack->socket_recv_release(_socket, data);
+    }
+
+    _lock.unlock();
+}
+
 void UDPSocket::event()
 {
     _event_flag.set(READ_FLAG|WRITE_FLAG);
@@ -112,6 +112,92 @@ public:
     nsapi_size_or_error_t recvfrom(SocketAddress *address,
             void *data, nsapi_size_t size);
 
+    /** Send a packet gathered from several buffers over a UDP socket
+     *
+     *  Sends the concatenated buffers as one datagram to the specified
+     *  address, without copying them into one buffer first. Ancillary data
+     *  such as the hop limit or the source address is applied from info.
+     *  Flags in info that the stack cannot apply to a send, such as the
+     *  receive only ones, return NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  By default, sendmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @param iov      Buffers of data to send to the host
+     *  @param iovcnt   Number of buffers
+     *  @param info     Ancillary data to apply, or NULL
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t sendmsg(const SocketAddress &address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, const nsapi_msginfo_t *info = NULL);
+
+    /** Receive a packet scattered into several buffers over a UDP socket
+     *
+     *  Receives one datagram into the buffers in order and stores the
+     *  source address in address if address is not NULL. The ancillary
+     *  data requested in info->flags, such as the hop limit or the link
+     *  quality of the last hop, is returned in info.
+     *
+     *  By default, recvmsg blocks until data is received. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Destination buffers for data received from the host
+     *  @param iovcnt   Number of buffers
+     *  @param info     Requested ancillary data and its destination, or NULL
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvmsg(SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt, nsapi_msginfo_t *info = NULL);
+
+    /** Receive several packets over a UDP socket
+     *
+     *  Drains up to count queued datagrams into the slots in one call, so
+     *  that the stack is locked once for the whole batch. Each slot gets
+     *  its own buffer, source address and requested ancillary data.
+     *
+     *  By default, recvmmsg blocks until at least one datagram is
+     *  received. If socket is set to non-blocking or times out,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param msgs     Slots to receive the datagrams into
+     *  @param count    Number of slots
+     *  @return         Number of received datagrams on success, negative
+     *                  error code on failure
+     */
+    nsapi_size_or_error_t recvmmsg(nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a packet over a UDP socket into a buffer allocated for it
+     *
+     *  Points data at a buffer that holds the datagram, followed by a
+     *  terminating zero byte. Whether this avoids a copy depends on the
+     *  network stack: Nanostack copies every datagram into a heap block
+     *  of its size, which costs one allocation per packet, so recvfrom
+     *  into a reused buffer is the cheaper choice there. The buffer must
+     *  be given back with release before the socket is closed.
+     *
+     *  By default, recv_borrow blocks until a datagram is received. If
+     *  socket is set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK
+     *  is returned immediately.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param data     Destination for the pointer to the received data
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recv_borrow(SocketAddress *address, const void **data);
+
+    /** Give a buffer from recv_borrow back to the network stack
+     *
+     *  @param data     Data pointer returned by recv_borrow
+     */
+    void release(const void *data);
+
 protected:
     virtual nsapi_protocol_t get_proto();
     virtual void event();
@@ -167,6 +167,86 @@ typedef enum nsapi_protocol {
    NSAPI_UDP, /*!< Socket is of UDP type */
 } nsapi_protocol_t;
 
+/** Scatter/gather buffer for sendmsg and recvmsg
+ */
+typedef struct nsapi_iovec {
+    void *iov_base;         /*!< Start of the buffer */
+    nsapi_size_t iov_len;   /*!< Length of the buffer in bytes */
+} nsapi_iovec_t;
+
+/** Enum of ancillary data fields of nsapi_msginfo_t
+ *
+ *  Set in nsapi_msginfo_t::flags to request the fields from recvmsg or to
+ *  apply them in sendmsg. recvmsg returns the fields that were filled in.
+ *
+ *  @enum nsapi_msginfo_flag
+ */
+typedef enum nsapi_msginfo_flag {
+    NSAPI_MSGINFO_HOP_LIMIT    = 0x01, /*!< hop_limit is valid */
+    NSAPI_MSGINFO_PKTINFO      = 0x02, /*!< local_addr and interface_id are valid */
+    NSAPI_MSGINFO_LINK_QUALITY = 0x04, /*!< link_quality is valid, receive only */
+    NSAPI_MSGINFO_TRUNCATED    = 0x08, /*!< Datagram did not fit into the buffers, receive only */
+    NSAPI_MSGINFO_TIMESTAMP    = 0x10, /*!< timestamp is valid, receive only, needs NSAPI_TIMESTAMP */
+} nsapi_msginfo_flag_t;
+
+/** Ancillary data of a datagram for sendmsg and recvmsg
+ */
+typedef struct nsapi_msginfo {
+    /** Combination of nsapi_msginfo_flag_t */
+    uint32_t flags;
+
+    /** Hop limit the datagram was received with, or to send it with */
+    int16_t hop_limit;
+
+    /** Stack-specific interface the datagram arrived on, or to send it on */
+    int8_t interface_id;
+
+    /** Link quality of the last hop as reported by the radio, higher is better */
+    uint8_t link_quality;
+
+    /** Destination address of a received datagram, or the source address to send from */
+    nsapi_addr_t local_addr;
+
+    /** Time the datagram was received, in us_ticker_read() microseconds
+     *
+     *  The stack may give the radio time of the last frame received or
+     *  the time it delivered the datagram, see the stack's documentation
+     */
+    uint32_t timestamp;
+} nsapi_msginfo_t;
+
+/** Datagram slot for recvmmsg
+ *
+ *  The caller sets buffer and size, and info.flags to request ancillary
+ *  data. The other fields are filled in when a datagram is received into
+ *  the slot.
+ */
+typedef struct nsapi_mmsg {
+    void *buffer;           /*!< Destination buffer */
+    nsapi_size_t size;      /*!< Size of the destination buffer in bytes */
+    nsapi_size_t length;    /*!< Number of bytes received */
+    nsapi_addr_t addr;      /*!< Source address */
+    uint16_t port;          /*!< Source port */
+    nsapi_msginfo_t info;   /*!< Requested and returned ancillary data */
+} nsapi_mmsg_t;
+
+/** Enum of socket events for Socket::notify
+ *
+ *  Readable and writable are signalled once and then again only after the
+ *  application drained the socket, i.e. a receive or send call returned
+ *  NSAPI_ERROR_WOULD_BLOCK. TX done and TX fail are signalled for every
+ *  datagram or segment.
+ *
+ *  @enum nsapi_socket_event
+ */
+typedef enum nsapi_socket_event {
+    NSAPI_SOCKET_EVENT_READABLE = 0x01, /*!< Data or a connection can be received */
+    NSAPI_SOCKET_EVENT_WRITABLE = 0x02, /*!< Data can be sent */
+    NSAPI_SOCKET_EVENT_TX_DONE  = 0x04, /*!< Sent data was handed to the link layer */
+    NSAPI_SOCKET_EVENT_TX_FAIL  = 0x08, /*!< Sent data was dropped, the reason is given */
+    NSAPI_SOCKET_EVENT_ALL      = 0x0f, /*!< All of the above */
+} nsapi_socket_event_t;
+
 /** Enum of standardized stack option levels
  *  for use with NetworkStack::setstackopt and getstackopt.
  *
@@ -214,8 +294,48 @@ typedef enum nsapi_socket_option {
     NSAPI_LINGER,    /*!< Keeps close from returning until queues empty */
     NSAPI_SNDBUF,    /*!< Sets send buffer size */
     NSAPI_RCVBUF,    /*!< Sets recv buffer size */
+    NSAPI_TXQUEUE,   /*!< Gets the transmit queue occupancy as nsapi_txqueue_t */
+    NSAPI_TXLOWAT,   /*!< Sets the pending datagram count at or below which NSAPI_SOCKET_EVENT_WRITABLE is signalled, 0 for every TX done */
+    NSAPI_NODELAY,   /*!< Disables the Nagle algorithm of a TCP socket, as int */
+    NSAPI_TIMESTAMP, /*!< Enables receive and transmit completion timestamps, as int */
+    NSAPI_TXTIMESTAMP, /*!< Gets and removes the oldest unread transmit completion as nsapi_txtimestamp_t */
+    NSAPI_TXQUEUE_DEST, /*!< Gets the pending datagrams of the socket to one destination as nsapi_txdest_t */
 } nsapi_socket_option_t;
 
+/** Transmit queue occupancy returned by the NSAPI_TXQUEUE socket option
+ */
+typedef struct nsapi_txqueue {
+    uint16_t socket_pending;    /*!< Datagrams of the socket handed to the stack and not yet sent or dropped */
+    uint16_t socket_lowat;      /*!< Low watermark set with NSAPI_TXLOWAT */
+    uint16_t link_queue;        /*!< Frames in the link layer transmit queue */
+    uint16_t link_queue_peak;   /*!< Highest link_queue since the statistics were reset */
+    uint16_t link_overflow;     /*!< Frames dropped because the link layer transmit queue was full */
+} nsapi_txqueue_t;
+
+/** Pending datagrams to one destination, for the NSAPI_TXQUEUE_DEST socket option
+ *
+ *  The caller sets addr and port, the stack fills in the rest. A stack
+ *  that does not report which datagram a transmission completed matches
+ *  completions to destinations in send order, so the count is exact only
+ *  while frames complete in the order they were sent.
+ */
+typedef struct nsapi_txdest {
+    nsapi_addr_t addr;          /*!< Destination address */
+    uint16_t port;              /*!< Destination port */
+    uint16_t pending;           /*!< Datagrams to the destination handed to the stack and not yet sent or dropped */
+    uint16_t untracked;         /*!< Pending datagrams of the socket not counted to any destination, pending can be this much higher */
+} nsapi_txdest_t;
+
+/** Transmit completion returned by the NSAPI_TXTIMESTAMP socket option
+ *
+ *  Completions are kept in the order the datagrams were sent. Reading
+ *  one with no completion pending returns NSAPI_ERROR_WOULD_BLOCK.
+ */
+typedef struct nsapi_txtimestamp {
+    uint32_t timestamp;         /*!< Time the transmission completed, in us_ticker_read() microseconds */
+    nsapi_error_t result;       /*!< NSAPI_ERROR_OK, or the reason of the TX fail */
+} nsapi_txtimestamp_t;
+
 /** Supported IP protocol versions of IP stack
  *
  *  @enum nsapi_ip_stack
@@ -16,19 +16,26 @@
 #include "mbed.h"
 #include "nanostack/socket_api.h"
 #include "mesh_led_control_example.h"
+#include "benchmark_report.h"
+#include "multicast_benchmark.h"
+#include "topology_snapshot.h"
+#include "test_config.h"
+#include "name_cache.h"
+#include "NanostackInterface.h"
+#include "us_ticker_api.h"
 #include "common_functions.h"
 #include "ip6string.h"
 #include "mbed-trace/mbed_trace.h"
 
 static void init_socket();
-static void handle_socket();
+static void handle_socket(uint32_t events, nsapi_error_t reason);
 static void receiver_report();
 static void receive();
 static void my_button_isr();
 static void send_message();
 static void blink();
 static void update_state(uint8_t state);
-static void handle_message(char* msg);
+static void handle_message(const char* msg);
 
 #define multicast_addr_str "ff15::810a:64d1"
 #define TRACE_GROUP "example"
@@ -41,6 +48,16 @@ extern Serial pc;
 void scan_sdna(char buffer[]);
 static void input_info();
 static void packet_send_worker();
+static void packet_send_isr();
+static void multicast_source_switch();
+static void multicast_source_isr();
+static void sender_button_isr();
+static void receiver_button_isr();
+static void receiver_switch();
+static void fill_dummy_length();
+static void store_config();
+static void resolve_destination();
+static bool console_interrupt(int timeout_ms);
 
 //DigitalOut output(A4, 1);
 DigitalOut led_1(A5, 1);    // for the NXP new board testing
@@ -52,16 +69,25 @@ InterruptIn my_button(SW3); // for the NXP new board testing
 NetworkInterface * network_if;
 UDPSocket* my_socket;
 // queue for sending messages from button press.
-EventQueue queue;
+#if MBED_CONF_APP_ENABLE_LED_CONTROL_EXAMPLE && MBED_CONF_NANOSTACK_HAL_EVENT_LOOP_USE_MBED_EVENTS
+// button events prompt on the console and wait for NVM, which would stop
+// the Nanostack event loop running on the shared event queue
+#error "The Led control example cannot run with nanostack-hal.event_loop_use_mbed_events"
+#endif
+EventQueue app_queue;
+EventQueue *queue = &app_queue;
 // for LED blinking
 Ticker ticker;
 // Handle for delayed message send
 int queue_handle = 0;
 
 uint8_t multi_cast_addr[16] = {0};
-uint8_t receive_buffer[256];
+// datagrams drained from the socket per recvmmsg() call
+static uint8_t receive_buffers[MBED_CONF_APP_RECEIVE_BATCH][256];
+static nsapi_mmsg_t receive_msgs[MBED_CONF_APP_RECEIVE_BATCH];
 
-uint8_t destination_addr[16] = {0};
+// resolved once per test configuration, not on every send
+static SocketAddress destination_sockaddr;
 char destination_buffer[128];
 char target_buffer[5];
 char dummy_length[128];
@@ -80,7 +106,14 @@ long receive_count=0;
 int led_state =0;
 
 
-int action_mode =0; // 0=receiver , 1=sender
+int action_mode =0; // 0=receiver , 1=sender , 2=multicast source
+long multicast_count=100;
+int multicast_interval_ms=100;
+int multicast_length=50;
+
+// last test configuration, resumed from NVM on boot
+static test_config_t test_config;
+static bool resume_config = false;
 // how many hops the multicast message can go
 static const int16_t multicast_hops = 10;
 bool button_status = 0;
@@ -92,6 +125,12 @@ void start_mesh_led_control_example(NetworkInterface * interface){
 
     network_if = interface;
     stoip6(multicast_addr_str, strlen(multicast_addr_str), multi_cast_addr);
+    benchmark_report_init(network_if);
+    // every node takes part in the multicast benchmark as a receiver
+    int8_t interface_id = static_cast<MeshInterfaceNanostack *>(network_if)->get_interface_id();
+    multicast_benchmark_init(interface_id, multi_cast_addr, queue);
+    topology_snapshot_init(interface_id, queue);
+    name_cache_init(interface_id, queue);
     init_socket();
 }
 
@@ -109,7 +148,7 @@ void cancel_blinking() {
 }
 static void packet_send_worker() {
     total_send_try++;
-    char buf[256];
+    char buf[40];
     int length;
 
     /**
@@ -119,32 +158,64 @@ static void packet_send_worker() {
     * Light control message format:
     * t:lights;g:<group_id>;s:<1|0>;\0
     */
-    length = snprintf(buf, sizeof(buf), "%10ld/%10ld:%s",total_send_try,send_try,dummy_length);
+    // seq/goal/sender us_ticker timestamp, the receiver derives latency from it
+    length = snprintf(buf, sizeof(buf), "%10ld/%10ld/%10lu:",total_send_try,send_try,
+                      (unsigned long)us_ticker_read());
     MBED_ASSERT(length > 0);
+    // header and payload are sent from their own buffers
+    nsapi_iovec_t iov[2];
+    iov[0].iov_base = buf;
+    iov[0].iov_len = length;
+    iov[1].iov_base = dummy_length;
+    iov[1].iov_len = strlen(dummy_length);
+    length += iov[1].iov_len;
     //printf("TX message, %u bytes: %s\n", length, buuf);
     printf(" seq : %10ld/%10ld ,", total_send_try,send_try);
     printf("len : %u , ", length);
     printf("interval : %d , ", send_interbal);
+    // occupancy before this packet is queued
+    nsapi_txqueue_t txqueue;
+    unsigned txqueue_len = sizeof(txqueue);
+    if (my_socket->getsockopt(NSAPI_SOCKET, NSAPI_TXQUEUE, &txqueue, &txqueue_len) == NSAPI_ERROR_OK) {
+        printf("pending : %u , txq : %u/%u , ", txqueue.socket_pending, txqueue.link_queue, txqueue.link_queue_peak);
+    }
+    nsapi_txdest_t txdest;
+    unsigned txdest_len = sizeof(txdest);
+    txdest.addr = destination_sockaddr.get_addr();
+    txdest.port = destination_sockaddr.get_port();
+    if (destination_sockaddr && my_socket->getsockopt(NSAPI_SOCKET, NSAPI_TXQUEUE_DEST, &txdest, &txdest_len) == NSAPI_ERROR_OK) {
+        printf("to dest : %u , ", txdest.pending);
+    }
     printf("Tx to : %s \n", destination_buffer);
-    SocketAddress send_sockAddr(destination_addr, NSAPI_IPv6, UDP_PORT);
-    my_socket->sendto(send_sockAddr, buf, 50);
+    if (destination_sockaddr) {
+        benchmark_report_tx(my_socket->sendmsg(destination_sockaddr, iov, 2));
+    } else {
+        printf("destination not resolved, not sent\n");
+    }
     
     if(total_send_try >= send_try){
         ticker.detach();
         total_send_try=0;
         thread_flag=0;
+        benchmark_report_finish();
+        topology_snapshot_start(true);
     }
     //After message is sent, it is received from the network
 }
 
 
+static void packet_send_isr() {
+    // Ticker runs in interrupt context, send from the event queue
+    queue->call(packet_send_worker);
+}
+
 static void send_message() {
     //printf("send msg %d\n", button_status);
 
-    
-
-    stoip6(destination_buffer, strlen(destination_buffer), destination_addr);
-    SocketAddress send_usi_sockAddr(destination_addr, NSAPI_IPv6, UDP_PORT);
+    if (!destination_sockaddr) {
+        printf("destination not resolved\n");
+        return;
+    }
 
     char buf[20];
     int length;
@@ -161,14 +232,27 @@ static void send_message() {
     printf("Sending lightcontrol message, %u bytes: %s\n", length, buf);
     SocketAddress send_sockAddr(multi_cast_addr, NSAPI_IPv6, UDP_PORT);
     //my_socket->sendto(send_sockAddr, buf, 20);
-    my_socket->sendto(send_usi_sockAddr, buf, 20);
+    my_socket->sendto(destination_sockaddr, buf, 20);
     //After message is sent, it is received from the network
 }
 
 // As this comes from isr, we cannot use printing or network functions directly from here.
 static void input_info(){
+    if(resume_config){
+        resume_config=false;
+        memset(destination_buffer, '\0', 128);
+        strncpy(destination_buffer, test_config.destination, TEST_CONFIG_DESTINATION_MAX - 1);
+        resolve_destination();
+        send_length = test_config.send_length;
+        send_interbal = test_config.send_interval;
+        send_try = test_config.send_try;
+        fill_dummy_length();
+        printf("resumed : destination %s , length 23 + %d , interbal %d , send_try %ld \n",
+               destination_buffer, send_length, send_interbal, send_try);
+        return;
+    }
     //printf("switch_3 active input info\n");
-    printf("enter destinatino addr : \n");
+    printf("enter destinatino addr, or @name : \n");
     int flag=0;
     int index=0;
 
@@ -177,7 +261,8 @@ static void input_info(){
     memset(destination_buffer, '\0', 128);
 
 
-    index =  snprintf(destination_buffer, sizeof(destination_buffer), "fd00:db8::ff:fe00:");
+    int prefix_length =  snprintf(destination_buffer, sizeof(destination_buffer), "fd00:db8::ff:fe00:");
+    index = prefix_length;
     while(flag==0){
         c = pc.getc();
         pc.putc(c);
@@ -187,16 +272,16 @@ static void input_info(){
         if(c==13){flag=1;} //means enter key
         if(c==127){index = index-2;} // means back space key
     }
+    // drop the enter key
+    destination_buffer[index - 1] = '\0';
+    if(destination_buffer[prefix_length] == '@'){
+        // node name instead of the address suffix
+        memmove(destination_buffer, destination_buffer + prefix_length + 1, strlen(destination_buffer + prefix_length));
+    }
     flag=0; index=0;
     printf("\n");
     printf(" destinatino receivced : %s \n",destination_buffer);
-
-    int length;
-    char buf[20];
-
-    length = snprintf(buf, sizeof(buf), "send ping : 20bytes.") + 1;
-    stoip6(destination_buffer, strlen(destination_buffer), destination_addr);
-    SocketAddress send_sockAddr(destination_addr, NSAPI_IPv6, UDP_PORT);
+    resolve_destination();
 
 
     char temp[10];
@@ -204,10 +289,7 @@ static void input_info(){
     scan_sdna(temp); 
     send_length = atoi(temp);
     printf("length : 23 + %d \n", send_length);
-    memset(dummy_length, '\0', 128);
-    for(;index <= send_length;index++){
-        dummy_length[index] = 65;
-    }
+    fill_dummy_length();
     memset(temp, '\0', 10);
 
     printf("enter send interbal : \n");
@@ -224,24 +306,121 @@ static void input_info(){
 
     index=0;
     flag=0;
+    store_config();
 //    printf("unicast send end\n");
 }
 
+static void destination_resolved(nsapi_error_t result, SocketAddress address){
+    if(result != NSAPI_ERROR_OK){
+        printf("destination %s not resolved : %d\n", destination_buffer, result);
+        return;
+    }
+    destination_sockaddr = address;
+    printf("destination %s : %s\n", destination_buffer, address.get_ip_address());
+}
+
+static void resolve_destination(){
+    destination_sockaddr = SocketAddress();
+    nsapi_error_t ret = name_cache_resolve(destination_buffer, UDP_PORT, callback(destination_resolved));
+    if(ret != NSAPI_ERROR_OK){
+        printf("destination %s not resolved : %d\n", destination_buffer, ret);
+    }
+}
+
+static void fill_dummy_length(){
+    memset(dummy_length, '\0', 128);
+    for(int index=0;index <= send_length && index < 127;index++){
+        dummy_length[index] = 65;
+    }
+}
+
+static void store_config(){
+    test_config.action_mode = action_mode;
+    memset(test_config.destination, '\0', TEST_CONFIG_DESTINATION_MAX);
+    strncpy(test_config.destination, destination_buffer, TEST_CONFIG_DESTINATION_MAX - 1);
+    test_config.send_length = send_length;
+    test_config.send_interval = send_interbal;
+    test_config.send_try = send_try;
+    test_config.receive_goal = total_receive_try;
+    test_config.multicast_count = multicast_count;
+    test_config.multicast_interval_ms = multicast_interval_ms;
+    test_config.multicast_length = multicast_length;
+    if(!test_config_save(&test_config)){
+        printf("test configuration not stored\n");
+    }
+}
+
+// Returns true if a key is pressed within timeout_ms
+static bool console_interrupt(int timeout_ms){
+    Timer timer;
+    timer.start();
+    while(timer.read_ms() < timeout_ms){
+        if(pc.readable()){
+            pc.getc();
+            return true;
+        }
+        Thread::wait(10);
+    }
+    return false;
+}
+
 static void my_button_isr() {
     if(thread_flag==0){
         thread_flag=1;
         total_send_try=0;
         input_info();
         printf("\n\nSTART PING SEND\n\n");
-        ticker.attach(packet_send_worker, send_interbal);
+        benchmark_report_start(BENCHMARK_ROLE_SENDER, send_try, send_length, send_interbal);
+        ticker.attach(packet_send_isr, send_interbal);
     }else{
         ticker.detach();
         total_send_try=0;
         thread_flag=0;
+        benchmark_report_finish();
+        topology_snapshot_start(true);
     }
     //button_status = !button_status;
 }
 
+static void multicast_source_switch() {
+    if(thread_flag==0){
+        if(resume_config){
+            resume_config=false;
+            multicast_count = test_config.multicast_count;
+            multicast_interval_ms = test_config.multicast_interval_ms;
+            multicast_length = test_config.multicast_length;
+        }else{
+            char temp[10];
+            printf("enter multicast send count : \n");
+            scan_sdna(temp);
+            multicast_count = atol(temp);
+            memset(temp, '\0', 10);
+
+            printf("enter multicast send interval ms : \n");
+            scan_sdna(temp);
+            multicast_interval_ms = atoi(temp);
+            memset(temp, '\0', 10);
+
+            printf("enter multicast send length : \n");
+            scan_sdna(temp);
+            multicast_length = atoi(temp);
+            store_config();
+        }
+
+        printf("\n\nSTART MULTICAST SEND to %s\n\n", multicast_addr_str);
+        multicast_benchmark_start_source(multicast_count, multicast_interval_ms, multicast_length);
+        thread_flag=1;
+    }else{
+        multicast_benchmark_stop_source();
+        thread_flag=0;
+    }
+}
+
+static void multicast_source_isr() {
+    // InterruptIn runs in interrupt context, prompt from the event queue
+    queue->call(multicast_source_switch);
+}
+
 static void update_state(uint8_t state) {
     if (state == 1) {
        printf("Turning led on\n\n");
@@ -257,7 +436,7 @@ static void update_state(uint8_t state) {
    }
 }
 
-static void handle_message(char* msg) {
+static void handle_message(const char* msg) {
     // Check if this is lights message
     uint8_t state=button_status;
     uint16_t group=0xffff;
@@ -274,7 +453,7 @@ static void handle_message(char* msg) {
     }
 
     // 0==master, 1==default group
-    char *msg_ptr = strstr(msg, "g:");
+    const char *msg_ptr = strstr(msg, "g:");
     if (msg_ptr) {
         char *ptr;
         group = strtol(msg_ptr, &ptr, 10);
@@ -288,11 +467,18 @@ static void handle_message(char* msg) {
 static void receiver_switch(){
     if(thread_flag==0){
         printf("report thread active\n");
-        printf("Enter goal : \n");
-        char temp[5];
-        scan_sdna(temp);
-        total_receive_try = atoi(temp);
+        if(resume_config){
+            resume_config=false;
+            total_receive_try = test_config.receive_goal;
+        }else{
+            printf("Enter goal : \n");
+            char temp[5];
+            scan_sdna(temp);
+            total_receive_try = atoi(temp);
+            store_config();
+        }
         printf("goal : %ld \n", total_receive_try);
+        benchmark_report_start(BENCHMARK_ROLE_RECEIVER, total_receive_try, 0, 0);
         thread_flag=1;
     }else{
          printf("report thread end\n");
@@ -307,125 +493,177 @@ static void receiver_report(){
     float psr = (float)receive_count / (float)total_receive_try * 100.0;
     printf("\n\n\nEnd Receiver mode - Report \n");
     printf("  Goal count = %ld , receive = %ld  , successivity= %0.3f %%\n", total_receive_try, receive_count, psr);
+    benchmark_report_finish();
+    topology_snapshot_start(true);
 }
-static void receive_receiver(){
-     // Read data from the socket
-    // static long last_seq =0;
-    SocketAddress source_addr;
-
-    memset(receive_buffer, 0, sizeof(receive_buffer));
-    bool something_in_socket=true;
-    // read all messages
-    while (something_in_socket) {
-        int length = my_socket->recvfrom(&source_addr, receive_buffer, sizeof(receive_buffer) - 1);
-        if (length > 0) {
-            //int timeout_value = MESSAGE_WAIT_TIMEOUT;
-                uint8_t temp[10];
-                memcpy(temp, receive_buffer, 10);
-                long now_seq = atol((char*)temp);
-                // printf("now seq %ld, last_seq %ld \n", now_seq, last_seq);
-            if( thread_flag==1){ //reporting
-                receive_count++;              
-
-                int len = strlen((char*)receive_buffer);
-                printf("RX from %s, ", source_addr.get_ip_address());
-                printf("len %d , ",len);  //why always 50???
-                //printf("message: %s\n",receive_buffer);
-                printf("conunt %ld , ",receive_count);
-                printf("seq %.10s  , ", receive_buffer);
-
-
-                // uint8_t* temp2[10];
-                // memcpy(temp2, receive_buffer, 10);
-                // long now_seq2 = atol((char*)temp2);
-                float psr2 = (float)receive_count / (float) now_seq * 100.0;
-                printf("psr %0.1f \n",psr2);
-                // last_seq = now_seq;
-
-                // float psr = (float)receive_count/(float)total_receive_try * 100.0;
-                // printf("psr %0.1f %%  \n",psr); // 0.00....
-
-                if(
-                    receive_buffer[0] == receive_buffer[11] && // receivce_buffer[10] = "/"
-                    receive_buffer[1] == receive_buffer[12] &&
-                    receive_buffer[2] == receive_buffer[13] &&
-                    receive_buffer[3] == receive_buffer[14] &&
-                    receive_buffer[4] == receive_buffer[15] &&
-                    receive_buffer[5] == receive_buffer[16] &&
-                    receive_buffer[6] == receive_buffer[17] &&
-                    receive_buffer[7] == receive_buffer[18] &&
-                    receive_buffer[8] == receive_buffer[19] &&
-                    receive_buffer[9] == receive_buffer[20]             
-                    ){
-                    printf("receive end packet report thread end\n");
-                    receiver_report();
-                    thread_flag=0;
-                    total_receive_try=0;
-                    receive_count=0;
-                }
-
-
-            }else{ // not reporting just print
-                 printf("Packet from %s\n", source_addr.get_ip_address());
-            }
+static void receive_receiver_packet(nsapi_mmsg_t *msg){
+    uint8_t *receive_buffer = (uint8_t *)msg->buffer;
+    nsapi_msginfo_t &info = msg->info;
+    SocketAddress source_addr(msg->addr, msg->port);
+
+    receive_buffer[msg->length] = '\0';
+    //int timeout_value = MESSAGE_WAIT_TIMEOUT;
+        uint8_t temp[10];
+        memcpy(temp, receive_buffer, 10);
+        long now_seq = atol((char*)temp);
+        // printf("now seq %ld, last_seq %ld \n", now_seq, last_seq);
+    if( thread_flag==1){ //reporting
+        receive_count++;              
+        // receive_buffer[21] = "/", sender timestamp follows
+        uint32_t tx_timestamp = strtoul((char*)&receive_buffer[22], NULL, 10);
+        // radio time if the stack reported it, not when the queue got to it
+        uint32_t rx_timestamp = (info.flags & NSAPI_MSGINFO_TIMESTAMP) ? info.timestamp : us_ticker_read();
+        benchmark_report_rx(source_addr, now_seq, tx_timestamp, rx_timestamp);
+
+        int len = strlen((char*)receive_buffer);
+        printf("RX from %s, ", source_addr.get_ip_address());
+        printf("len %d , ",len);  //why always 50???
+        //printf("message: %s\n",receive_buffer);
+        printf("conunt %ld , ",receive_count);
+        printf("seq %.10s  , ", receive_buffer);
+        if (info.flags & NSAPI_MSGINFO_HOP_LIMIT) {
+            printf("hop limit %d , ", info.hop_limit);
+        }
+        if (info.flags & NSAPI_MSGINFO_LINK_QUALITY) {
+            printf("lqi %u , ", info.link_quality);
         }
-        else if (length!=NSAPI_ERROR_WOULD_BLOCK) {
-            tr_error("Error happened when receiving %d\n", length);
-            something_in_socket=false;
+
+
+        // uint8_t* temp2[10];
+        // memcpy(temp2, receive_buffer, 10);
+        // long now_seq2 = atol((char*)temp2);
+        float psr2 = (float)receive_count / (float) now_seq * 100.0;
+        printf("psr %0.1f \n",psr2);
+        // last_seq = now_seq;
+
+        // float psr = (float)receive_count/(float)total_receive_try * 100.0;
+        // printf("psr %0.1f %%  \n",psr); // 0.00....
+
+        if(
+            receive_buffer[0] == receive_buffer[11] && // receivce_buffer[10] = "/"
+            receive_buffer[1] == receive_buffer[12] &&
+            receive_buffer[2] == receive_buffer[13] &&
+            receive_buffer[3] == receive_buffer[14] &&
+            receive_buffer[4] == receive_buffer[15] &&
+            receive_buffer[5] == receive_buffer[16] &&
+            receive_buffer[6] == receive_buffer[17] &&
+            receive_buffer[7] == receive_buffer[18] &&
+            receive_buffer[8] == receive_buffer[19] &&
+            receive_buffer[9] == receive_buffer[20]             
+            ){
+            printf("receive end packet report thread end\n");
+            receiver_report();
+            thread_flag=0;
+            total_receive_try=0;
+            receive_count=0;
         }
-        else {
+
+
+    }else{ // not reporting just print
+         printf("Packet from %s\n", source_addr.get_ip_address());
+    }
+}
+
+static void receive_receiver(){
+    // read all messages, a batch per socket call
+    while (true) {
+        for (int i = 0; i < MBED_CONF_APP_RECEIVE_BATCH; i++) {
+            receive_msgs[i].buffer = receive_buffers[i];
+            receive_msgs[i].size = sizeof(receive_buffers[i]) - 1;
+            receive_msgs[i].info.flags = NSAPI_MSGINFO_HOP_LIMIT | NSAPI_MSGINFO_LINK_QUALITY | NSAPI_MSGINFO_TIMESTAMP;
+        }
+        int count = my_socket->recvmmsg(receive_msgs, MBED_CONF_APP_RECEIVE_BATCH);
+        if (count == NSAPI_ERROR_WOULD_BLOCK) {
             // there was nothing to read.
-            something_in_socket=false;
+            break;
+        }
+        if (count < 0) {
+            tr_error("Error happened when receiving %d\n", count);
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            receive_receiver_packet(&receive_msgs[i]);
+        }
+        if (count < MBED_CONF_APP_RECEIVE_BATCH) {
+            // socket drained
+            break;
         }
     }
 }
 
 static void receive() {
-    // Read data from the socket
-    SocketAddress source_addr;
-    memset(receive_buffer, 0, sizeof(receive_buffer));
-    bool something_in_socket=true;
-    // read all messages
-    while (something_in_socket) {
-        int length = my_socket->recvfrom(&source_addr, receive_buffer, sizeof(receive_buffer) - 1);
-        if (length > 0) {
-            //int timeout_value = MESSAGE_WAIT_TIMEOUT;
-            printf("Packet from %s\n", source_addr.get_ip_address());
-            // timeout_value += rand() % 30;
-            // printf("Advertisiment after %d seconds\n", timeout_value);
-            // queue.cancel(queue_handle);
-            // queue_handle = queue.call_in((timeout_value * 1000), send_message);
-            // // Handle command - "on", "off"
-            handle_message((char*)receive_buffer);
-        }
-        else if (length!=NSAPI_ERROR_WOULD_BLOCK) {
-            tr_error("Error happened when receiving %d\n", length);
-            something_in_socket=false;
+    // read all messages, a batch per socket call
+    while (true) {
+        for (int i = 0; i < MBED_CONF_APP_RECEIVE_BATCH; i++) {
+            receive_msgs[i].buffer = receive_buffers[i];
+            receive_msgs[i].size = sizeof(receive_buffers[i]) - 1;
+            receive_msgs[i].info.flags = 0;
         }
-        else {
+        int count = my_socket->recvmmsg(receive_msgs, MBED_CONF_APP_RECEIVE_BATCH);
+        if (count == NSAPI_ERROR_WOULD_BLOCK) {
             // there was nothing to read.
-            something_in_socket=false;
+            break;
+        }
+        if (count < 0) {
+            tr_error("Error happened when receiving %d\n", count);
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            SocketAddress source_addr(receive_msgs[i].addr, receive_msgs[i].port);
+            receive_buffers[i][receive_msgs[i].length] = '\0';
+            printf("Packet from %s\n", source_addr.get_ip_address());
+            // Handle command - "on", "off"
+            handle_message((const char*)receive_buffers[i]);
+        }
+        if (count < MBED_CONF_APP_RECEIVE_BATCH) {
+            // socket drained
+            break;
         }
     }
 }
-static void handle_socket_receiver() {
-    // call-back might come from ISR
-    queue.call(receive_receiver);
+static void sender_button_isr() {
+    // InterruptIn runs in interrupt context, prompt from the event queue
+    queue->call(my_button_isr);
+}
+
+static void receiver_button_isr() {
+    queue->call(receiver_switch);
+}
+
+static void handle_socket_receiver(uint32_t events, nsapi_error_t reason) {
+    // runs from the queue, readable is signalled again only
+    // after receive_receiver() drained the socket
+    receive_receiver();
 }
 
-static void handle_socket() {
-    // call-back might come from ISR
-    queue.call(receive);
+static void handle_socket(uint32_t events, nsapi_error_t reason) {
+    // runs from the queue, handed over by the socket event ring
+    if (events & NSAPI_SOCKET_EVENT_READABLE) {
+        receive();
+    }
+    if (events & NSAPI_SOCKET_EVENT_TX_FAIL) {
+        printf("TX failed %d\n", reason);
+    }
 }
 
 static void init_socket()
 {
-    char temp[5];
-    printf("enter action mode : ");
-    scan_sdna(temp); 
-    action_mode = atoi(temp);
-    printf("actino mode %d selected \n", action_mode);
-    memset(temp, '\0', 5);
+    if(test_config_load(&test_config)){
+        printf("press any key within %d ms to enter a new test configuration\n",
+               MBED_CONF_APP_AUTO_RESUME_TIMEOUT_MS);
+        resume_config = !console_interrupt(MBED_CONF_APP_AUTO_RESUME_TIMEOUT_MS);
+    }
+    if(resume_config){
+        action_mode = test_config.action_mode;
+        printf("actino mode %d resumed from stored configuration \n", action_mode);
+    }else{
+        char temp[5];
+        printf("enter action mode : ");
+        scan_sdna(temp); 
+        action_mode = atoi(temp);
+        printf("actino mode %d selected \n", action_mode);
+        memset(temp, '\0', 5);
+    }
 
     my_socket = new UDPSocket(network_if);
     my_socket->set_blocking(false);
@@ -437,28 +675,38 @@ static void init_socket()
     mreq.ipv6mr_interface = 0;
 
     my_socket->setsockopt(SOCKET_IPPROTO_IPV6, SOCKET_IPV6_JOIN_GROUP, &mreq, sizeof mreq);
+    // receive time for the latency report
+    static const int timestamp = 1;
+    my_socket->setsockopt(NSAPI_SOCKET, NSAPI_TIMESTAMP, &timestamp, sizeof timestamp);
 
     if(action_mode == 1 ){ // sender
         if (MBED_CONF_APP_BUTTON != NC) {
-            my_button.fall(&my_button_isr);
+            my_button.fall(&sender_button_isr);
             my_button.mode(PullUp);
         }
         //let's register the call-back function.
-        //If something happens in socket (packets in or out), the call-back is called.
-        my_socket->sigio(callback(handle_socket));
+        //It is called when packets come in or a send fails, not on every TX done.
+        my_socket->notify(NSAPI_SOCKET_EVENT_READABLE | NSAPI_SOCKET_EVENT_TX_FAIL, queue, callback(handle_socket));
         my_button_isr();
+    }else if(action_mode == 2 ){ // multicast source
+        if (MBED_CONF_APP_BUTTON != NC) {
+            my_button.fall(&multicast_source_isr);
+            my_button.mode(PullUp);
+        }
+        my_socket->notify(NSAPI_SOCKET_EVENT_READABLE | NSAPI_SOCKET_EVENT_TX_FAIL, queue, callback(handle_socket));
+        multicast_source_switch();
     }else{  //receiver
             if (MBED_CONF_APP_BUTTON != NC) {
-            my_button.fall(&receiver_switch);
+            my_button.fall(&receiver_button_isr);
             my_button.mode(PullUp);
         }
-        my_socket->sigio(callback(handle_socket_receiver));
+        my_socket->notify(NSAPI_SOCKET_EVENT_READABLE, queue, callback(handle_socket_receiver));
         receiver_switch();
     }
     
 
     // dispatch forever
-    queue.dispatch();
+    queue->dispatch();
 }
 
 
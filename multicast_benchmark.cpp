@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "us_ticker_api.h"
+#include "eventOS_scheduler.h"
+#include "common_functions.h"
+#include "ip6string.h"
+#include "nanostack/net_interface.h"
+#include "nanostack/socket_api.h"
+#include "nanostack/multicast_api.h"
+#include "multicast_benchmark.h"
+#include "benchmark_report.h"
+#include "benchmark_coap.h"
+
+/*
+ * The stream uses a Nanostack socket directly, as the receiver needs the
+ * hop limit of each datagram (SOCKET_IPV6_RECVHOPLIMIT), which is not
+ * available through the netsocket API. Socket callbacks run in the event
+ * loop thread, so all receiver state is only touched with the event loop
+ * mutex held.
+ *
+ * Packet layout:
+ *   'M' 'B' | seq (32) | count (32) | sender us_ticker (32) | hop limit (8) | padding
+ *
+ * Hop count is the initial hop limit minus the received one, plus one,
+ * so a direct neighbour of the source is at one hop.
+ */
+#define MCAST_HEADER_LEN        15
+#define MCAST_PACKET_MAX        256
+#define MCAST_MAX_SOURCES       4
+#define MCAST_REPLAY_WINDOW     32
+
+typedef struct {
+    uint32_t packets;
+    uint32_t latency_max;
+    uint64_t latency_sum;
+} mcast_hop_stats_t;
+
+typedef struct {
+    uint8_t address[16];
+    uint32_t count;
+    uint32_t highest_seq;
+    uint32_t window;
+    uint32_t unique;
+    uint32_t duplicates;
+    uint32_t offset_base;
+    uint32_t mac_rx_base;
+    uint32_t mac_bc_tx_base;
+    uint32_t mac_rx;
+    uint32_t mac_bc_tx;
+    mcast_hop_stats_t hops[MULTICAST_BENCHMARK_MAX_HOPS + 1];
+} mcast_source_t;
+
+static int8_t socket_id = -1;
+static uint8_t group_addr[16];
+static EventQueue *app_queue;
+static uint8_t source_count;
+static mcast_source_t sources[MCAST_MAX_SOURCES];
+
+static int tx_event;
+static uint32_t tx_seq;
+static uint32_t tx_count;
+static uint16_t tx_length;
+static uint32_t tx_ok;
+static uint32_t tx_err;
+static uint8_t tx_buffer[MCAST_PACKET_MAX];
+static const int16_t multicast_hops = MBED_CONF_APP_MPL_MULTICAST_HOPS;
+
+static mcast_source_t *source_get(const uint8_t address[16])
+{
+    for (uint8_t i = 0; i < source_count; i++) {
+        if (memcmp(sources[i].address, address, 16) == 0) {
+            return &sources[i];
+        }
+    }
+    if (source_count == MCAST_MAX_SOURCES) {
+        return NULL;
+    }
+    mcast_source_t *source = &sources[source_count++];
+    memset(source, 0, sizeof(*source));
+    memcpy(source->address, address, 16);
+    return source;
+}
+
+static void source_account(mcast_source_t *source, uint32_t seq, uint32_t offset, int16_t hop_limit, uint8_t initial_hops)
+{
+    nwk_stats_t stats;
+    benchmark_report_nwk_stats(&stats);
+
+    if (source->unique == 0 && source->duplicates == 0) {
+        source->offset_base = offset;
+        source->mac_rx_base = stats.mac_rx_count;
+        source->mac_bc_tx_base = stats.mac_bc_tx_count;
+    }
+    source->mac_rx = stats.mac_rx_count - source->mac_rx_base;
+    source->mac_bc_tx = stats.mac_bc_tx_count - source->mac_bc_tx_base;
+
+    if (source->unique == 0 || seq > source->highest_seq) {
+        uint32_t shift = source->unique ? seq - source->highest_seq : MCAST_REPLAY_WINDOW;
+        source->window = shift >= MCAST_REPLAY_WINDOW ? 0 : source->window << shift;
+        source->window |= 1;
+        source->highest_seq = seq;
+    } else {
+        uint32_t age = source->highest_seq - seq;
+        if (age < MCAST_REPLAY_WINDOW && (source->window & (1UL << age))) {
+            /* MPL seed set should have suppressed this copy */
+            source->duplicates++;
+            return;
+        }
+        if (age < MCAST_REPLAY_WINDOW) {
+            source->window |= 1UL << age;
+        }
+    }
+    source->unique++;
+
+    /* Relative to the first packet heard from the source, clocks are not synchronised */
+    int32_t latency_ms = (int32_t)(offset - source->offset_base) / 1000;
+
+    int hops = hop_limit >= 0 ? initial_hops - hop_limit + 1 : 0;
+    if (hops < 0) {
+        hops = 0;
+    } else if (hops > MULTICAST_BENCHMARK_MAX_HOPS) {
+        hops = MULTICAST_BENCHMARK_MAX_HOPS;
+    }
+    mcast_hop_stats_t *hop = &source->hops[hops];
+    hop->packets++;
+    if (latency_ms > 0) {
+        hop->latency_sum += latency_ms;
+        if ((uint32_t)latency_ms > hop->latency_max) {
+            hop->latency_max = latency_ms;
+        }
+    }
+}
+
+static void socket_receive(void)
+{
+    uint8_t buffer[MCAST_HEADER_LEN];
+    uint8_t ancillary[NS_CMSG_SPACE(sizeof(int16_t))];
+    ns_address_t address;
+    ns_iovec_t iov;
+    ns_msghdr_t msghdr;
+
+    for (;;) {
+        iov.iov_base = buffer;
+        iov.iov_len = sizeof(buffer);
+        msghdr.msg_name = &address;
+        msghdr.msg_namelen = sizeof(address);
+        msghdr.msg_iov = &iov;
+        msghdr.msg_iovlen = 1;
+        msghdr.msg_control = ancillary;
+        msghdr.msg_controllen = sizeof(ancillary);
+        msghdr.msg_flags = 0;
+
+        int16_t length = socket_recvmsg(socket_id, &msghdr, 0);
+        if (length < 0) {
+            return;
+        }
+        uint32_t offset = us_ticker_read();
+
+        if (length < MCAST_HEADER_LEN || buffer[0] != 'M' || buffer[1] != 'B') {
+            continue;
+        }
+
+        int16_t hop_limit = -1;
+        ns_cmsghdr_t *cmsg = NS_CMSG_FIRSTHDR(&msghdr);
+        while (cmsg) {
+            if (cmsg->cmsg_level == SOCKET_IPPROTO_IPV6 && cmsg->cmsg_type == SOCKET_IPV6_HOPLIMIT) {
+                memcpy(&hop_limit, NS_CMSG_DATA(cmsg), sizeof(hop_limit));
+            }
+            cmsg = NS_CMSG_NXTHDR(&msghdr, cmsg);
+        }
+
+        mcast_source_t *source = source_get(address.address);
+        if (!source) {
+            continue;
+        }
+        uint32_t seq = common_read_32_bit(&buffer[2]);
+        source->count = common_read_32_bit(&buffer[6]);
+        offset -= common_read_32_bit(&buffer[10]);
+        source_account(source, seq, offset, hop_limit, buffer[14]);
+
+        if (seq == source->count) {
+            app_queue->call(multicast_benchmark_report);
+        }
+    }
+}
+
+static void socket_callback(void *cb)
+{
+    socket_callback_t *sock_cb = (socket_callback_t *)cb;
+
+    if ((sock_cb->event_type & SOCKET_EVENT_MASK) == SOCKET_DATA) {
+        socket_receive();
+    }
+}
+
+static int coap_format(char *buffer, size_t length);
+
+int multicast_benchmark_init(int8_t interface_id, const uint8_t group[16], EventQueue *queue)
+{
+    int ret = -1;
+    bool enable = true;
+    bool disable = false;
+    ns_ipv6_mreq_t mreq;
+
+    app_queue = queue;
+    memcpy(group_addr, group, 16);
+
+    eventOS_scheduler_mutex_wait();
+    if (multicast_mpl_domain_subscribe_with_parameters(interface_id, group_addr,
+            MULTICAST_MPL_SEED_ID_DEFAULT,
+            NULL,
+            MBED_CONF_APP_MPL_PROACTIVE_FORWARDING,
+            MBED_CONF_APP_MPL_SEED_SET_ENTRY_LIFETIME,
+            MBED_CONF_APP_MPL_DATA_IMIN,
+            MBED_CONF_APP_MPL_DATA_IMAX,
+            MBED_CONF_APP_MPL_DATA_K,
+            MBED_CONF_APP_MPL_DATA_EXPIRATIONS,
+            MBED_CONF_APP_MPL_CONTROL_IMIN,
+            MBED_CONF_APP_MPL_CONTROL_IMAX,
+            MBED_CONF_APP_MPL_CONTROL_K,
+            MBED_CONF_APP_MPL_CONTROL_EXPIRATIONS) < 0) {
+        printf("multicast: MPL domain subscribe failed\n");
+        goto out;
+    }
+
+    socket_id = socket_open(SOCKET_UDP, MULTICAST_BENCHMARK_PORT, socket_callback);
+    if (socket_id < 0) {
+        printf("multicast: socket open failed\n");
+        goto out;
+    }
+
+    memcpy(mreq.ipv6mr_multiaddr, group_addr, 16);
+    mreq.ipv6mr_interface = interface_id;
+    socket_setsockopt(socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_JOIN_GROUP, &mreq, sizeof mreq);
+    socket_setsockopt(socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_RECVHOPLIMIT, &enable, sizeof enable);
+    socket_setsockopt(socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_MULTICAST_LOOP, &disable, sizeof disable);
+    socket_setsockopt(socket_id, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_MULTICAST_HOPS, &multicast_hops, sizeof multicast_hops);
+
+    benchmark_coap_register(MULTICAST_BENCHMARK_COAP_URI, BENCHMARK_COAP_TEXT_PLAIN, coap_format);
+    ret = 0;
+out:
+    eventOS_scheduler_mutex_release();
+    return ret;
+}
+
+static void source_send(void)
+{
+    ns_address_t address;
+
+    if (tx_seq >= tx_count) {
+        multicast_benchmark_stop_source();
+        return;
+    }
+    tx_seq++;
+
+    tx_buffer[0] = 'M';
+    tx_buffer[1] = 'B';
+    common_write_32_bit(tx_seq, &tx_buffer[2]);
+    common_write_32_bit(tx_count, &tx_buffer[6]);
+    common_write_32_bit(us_ticker_read(), &tx_buffer[10]);
+    tx_buffer[14] = (uint8_t)multicast_hops;
+
+    address.type = ADDRESS_IPV6;
+    memcpy(address.address, group_addr, 16);
+    address.identifier = MULTICAST_BENCHMARK_PORT;
+
+    eventOS_scheduler_mutex_wait();
+    int16_t ret = socket_sendto(socket_id, &address, tx_buffer, tx_length);
+    eventOS_scheduler_mutex_release();
+
+    if (ret == 0) {
+        tx_ok++;
+    } else {
+        tx_err++;
+    }
+}
+
+void multicast_benchmark_start_source(uint32_t count, int interval_ms, uint16_t length)
+{
+    if (socket_id < 0 || tx_event) {
+        return;
+    }
+    if (length < MCAST_HEADER_LEN) {
+        length = MCAST_HEADER_LEN;
+    } else if (length > MCAST_PACKET_MAX) {
+        length = MCAST_PACKET_MAX;
+    }
+    memset(tx_buffer, 'A', sizeof(tx_buffer));
+    tx_seq = 0;
+    tx_count = count;
+    tx_length = length;
+    tx_ok = 0;
+    tx_err = 0;
+    printf("multicast: sourcing %lu packets of %u bytes every %d ms\n",
+           (unsigned long)count, length, interval_ms);
+    tx_event = app_queue->call_every(interval_ms, source_send);
+}
+
+void multicast_benchmark_stop_source(void)
+{
+    if (!tx_event) {
+        return;
+    }
+    app_queue->cancel(tx_event);
+    tx_event = 0;
+    printf("MCAST_TX,%lu,%lu,%lu\n", (unsigned long)tx_count,
+           (unsigned long)tx_ok, (unsigned long)tx_err);
+}
+
+static int format_source(char *buffer, size_t length, const mcast_source_t *source)
+{
+    char addr_str[40];
+    uint32_t lost = source->count > source->unique ? source->count - source->unique : 0;
+    int written;
+
+    ip6tos(source->address, addr_str);
+    /* Frames heard and broadcast per delivered message show how well
+     * trickle suppressed redundant forwarding around this node */
+    written = snprintf(buffer, length, "MCAST,%s,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                       addr_str, (unsigned long)source->count,
+                       (unsigned long)source->unique, (unsigned long)source->duplicates,
+                       (unsigned long)lost, (unsigned long)source->mac_rx,
+                       (unsigned long)source->mac_bc_tx);
+    for (int i = 0; i <= MULTICAST_BENCHMARK_MAX_HOPS; i++) {
+        const mcast_hop_stats_t *hop = &source->hops[i];
+        if (!hop->packets) {
+            continue;
+        }
+        if (written < 0 || (size_t)written >= length) {
+            return -1;
+        }
+        written += snprintf(buffer + written, length - written, "MCAST_HOP,%s,%d,%lu,%lu,%lu\n",
+                            addr_str, i, (unsigned long)hop->packets,
+                            (unsigned long)(hop->latency_sum / hop->packets),
+                            (unsigned long)hop->latency_max);
+    }
+    if (written < 0 || (size_t)written >= length) {
+        return -1;
+    }
+    return written;
+}
+
+static int format_sources(char *buffer, size_t length)
+{
+    int written = 0;
+
+    buffer[0] = '\0';
+    for (uint8_t i = 0; i < source_count; i++) {
+        int row = format_source(buffer + written, length - written, &sources[i]);
+        if (row < 0) {
+            buffer[written] = '\0';
+            break;
+        }
+        written += row;
+    }
+    return written;
+}
+
+static int coap_format(char *buffer, size_t length)
+{
+    /* Called from the event loop thread */
+    return format_sources(buffer, length);
+}
+
+void multicast_benchmark_report(void)
+{
+    static char buffer[1024];
+
+    eventOS_scheduler_mutex_wait();
+    format_sources(buffer, sizeof(buffer));
+    source_count = 0;
+    eventOS_scheduler_mutex_release();
+
+    printf("MCAST_COLUMNS,source,count,rx,dup,lost,mac_rx,mac_bc_tx\n"
+           "MCAST_HOP_COLUMNS,source,hops,rx,lat_mean_ms,lat_max_ms\n%s", buffer);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MULTICAST_BENCHMARK_H
+#define MULTICAST_BENCHMARK_H
+
+#include "mbed.h"
+
+/* UDP port of the multicast stream, separate from the unicast test port */
+#define MULTICAST_BENCHMARK_PORT        1235
+/* Hop counts above this are accounted in the last bin */
+#define MULTICAST_BENCHMARK_MAX_HOPS    8
+#define MULTICAST_BENCHMARK_COAP_URI    "mcast"
+
+/**
+ * Subscribe to the MPL domain of the group and start listening to the
+ * multicast stream. Every node runs the receiver side.
+ *
+ * \param interface_id Nanostack interface id of the mesh interface.
+ * \param group IPv6 multicast group, used as MPL domain address.
+ * \param queue Event queue the source sends from.
+ * \return 0 on success, negative on failure
+ */
+int multicast_benchmark_init(int8_t interface_id, const uint8_t group[16], EventQueue *queue);
+
+/**
+ * Start sourcing a sequenced stream to the group.
+ *
+ * \param count Number of packets to send.
+ * \param interval_ms Time between packets.
+ * \param length Packet length, including the benchmark header.
+ */
+void multicast_benchmark_start_source(uint32_t count, int interval_ms, uint16_t length);
+
+/** Stop sourcing. */
+void multicast_benchmark_stop_source(void);
+
+/** Print the receiver report of every source heard and start over. */
+void multicast_benchmark_report(void);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <ctype.h>
+#include "mbed.h"
+#include "eventOS_scheduler.h"
+#include "ip6string.h"
+#include "nanostack/net_interface.h"
+#include "name_cache.h"
+
+/*
+ * Nanostack only has the mDNS responder side (ns_mdns_api.h), so names
+ * cannot be queried from the network. They come from the static table,
+ * name_cache_add() and EUI-64 based SLAAC addresses. All state is used
+ * from the event queue thread only.
+ */
+#define NAME_CACHE_PENDING          4
+#define NAME_CACHE_RETRY_MS         1000
+
+typedef struct {
+    char name[NAME_CACHE_NAME_MAX];
+    uint8_t address[16];
+    uint32_t last_used;
+    bool is_static;
+} name_cache_entry_t;
+
+typedef struct {
+    bool used;
+    char name[NAME_CACHE_NAME_MAX];
+    uint16_t port;
+    int retries;
+    name_cache_callback_t callback;
+} name_cache_pending_t;
+
+static int8_t network_interface_id = -1;
+static EventQueue *app_queue;
+static name_cache_entry_t entries[MBED_CONF_APP_NAME_CACHE_SIZE];
+static uint8_t entry_count;
+static uint32_t use_counter;
+static name_cache_pending_t pending[NAME_CACHE_PENDING];
+static bool retry_scheduled;
+
+static name_cache_entry_t *entry_find(const char *name)
+{
+    for (uint8_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool entry_store(const char *name, const uint8_t address[16], bool is_static)
+{
+    if (strlen(name) >= NAME_CACHE_NAME_MAX) {
+        return false;
+    }
+    name_cache_entry_t *entry = entry_find(name);
+    if (!entry && entry_count < MBED_CONF_APP_NAME_CACHE_SIZE) {
+        entry = &entries[entry_count++];
+    }
+    if (!entry) {
+        /* Replace the least recently used dynamic entry */
+        for (uint8_t i = 0; i < entry_count; i++) {
+            if (!entries[i].is_static && (!entry || entries[i].last_used < entry->last_used)) {
+                entry = &entries[i];
+            }
+        }
+        if (!entry) {
+            return false;
+        }
+    }
+    strcpy(entry->name, name);
+    memcpy(entry->address, address, 16);
+    entry->last_used = ++use_counter;
+    entry->is_static = is_static;
+    return true;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = tolower(c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static bool parse_eui64(const char *name, uint8_t eui64[8])
+{
+    int digits = 0;
+
+    for (; *name; name++) {
+        if (*name == '-') {
+            continue;
+        }
+        int value = hex_value(*name);
+        if (value < 0 || digits == 16) {
+            return false;
+        }
+        if (digits & 1) {
+            eui64[digits / 2] |= value;
+        } else {
+            eui64[digits / 2] = value << 4;
+        }
+        digits++;
+    }
+    return digits == 16;
+}
+
+/* SLAAC address of the EUI-64 on the own /64, false until the own address is known */
+static bool resolve_eui64(const uint8_t eui64[8], uint8_t address[16])
+{
+    int ret;
+
+    eventOS_scheduler_mutex_wait();
+    ret = arm_net_address_get(network_interface_id, ADDR_IPV6_GP, address);
+    eventOS_scheduler_mutex_release();
+    if (ret != 0) {
+        return false;
+    }
+    memcpy(address + 8, eui64, 8);
+    /* Universal/local bit is inverted in the interface identifier */
+    address[8] ^= 0x02;
+    return true;
+}
+
+bool name_cache_lookup(const char *name, uint8_t address[16])
+{
+    uint8_t eui64[8];
+
+    if (strchr(name, ':')) {
+        stoip6(name, strlen(name), address);
+        return true;
+    }
+    name_cache_entry_t *entry = entry_find(name);
+    if (entry) {
+        entry->last_used = ++use_counter;
+        memcpy(address, entry->address, 16);
+        return true;
+    }
+    if (parse_eui64(name, eui64) && resolve_eui64(eui64, address)) {
+        entry_store(name, address, false);
+        return true;
+    }
+    return false;
+}
+
+bool name_cache_add(const char *name, const uint8_t address[16])
+{
+    return entry_store(name, address, false);
+}
+
+static void pending_run(void);
+
+static void pending_retry(void)
+{
+    retry_scheduled = false;
+    pending_run();
+}
+
+static void pending_run(void)
+{
+    uint8_t address[16];
+    uint8_t eui64[8];
+    bool retry = false;
+
+    for (uint8_t i = 0; i < NAME_CACHE_PENDING; i++) {
+        name_cache_pending_t *request = &pending[i];
+        if (!request->used) {
+            continue;
+        }
+        /* The slot is free for new requests from within the callback */
+        name_cache_callback_t callback = request->callback;
+        if (name_cache_lookup(request->name, address)) {
+            request->used = false;
+            callback(NSAPI_ERROR_OK, SocketAddress(address, NSAPI_IPv6, request->port));
+        } else if (parse_eui64(request->name, eui64) && request->retries-- > 0) {
+            /* Own global address not ready yet */
+            retry = true;
+        } else {
+            request->used = false;
+            callback(NSAPI_ERROR_DNS_FAILURE, SocketAddress());
+        }
+    }
+    if (retry && !retry_scheduled) {
+        retry_scheduled = true;
+        app_queue->call_in(NAME_CACHE_RETRY_MS, pending_retry);
+    }
+}
+
+nsapi_error_t name_cache_resolve(const char *name, uint16_t port, name_cache_callback_t callback)
+{
+    if (!app_queue || strlen(name) >= NAME_CACHE_NAME_MAX) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    for (uint8_t i = 0; i < NAME_CACHE_PENDING; i++) {
+        name_cache_pending_t *request = &pending[i];
+        if (request->used) {
+            continue;
+        }
+        request->used = true;
+        strcpy(request->name, name);
+        request->port = port;
+        request->retries = MBED_CONF_APP_NAME_CACHE_TIMEOUT_MS / NAME_CACHE_RETRY_MS;
+        request->callback = callback;
+        app_queue->call(pending_run);
+        return NSAPI_ERROR_OK;
+    }
+    return NSAPI_ERROR_NO_MEMORY;
+}
+
+static void load_static_table(const char *table)
+{
+    /* name=address,name=address */
+    while (*table) {
+        const char *end = strchr(table, ',');
+        size_t length = end ? (size_t)(end - table) : strlen(table);
+        const char *separator = (const char *)memchr(table, '=', length);
+        size_t name_length = separator ? (size_t)(separator - table) : 0;
+
+        if (separator && name_length > 0 && name_length < NAME_CACHE_NAME_MAX) {
+            char name[NAME_CACHE_NAME_MAX];
+            uint8_t address[16];
+            memcpy(name, table, name_length);
+            name[name_length] = '\0';
+            stoip6(separator + 1, length - name_length - 1, address);
+            if (!entry_store(name, address, true)) {
+                printf("name cache full, %s dropped\n", name);
+            }
+        }
+        table += length;
+        if (*table == ',') {
+            table++;
+        }
+    }
+}
+
+void name_cache_init(int8_t interface_id, EventQueue *queue)
+{
+    network_interface_id = interface_id;
+    app_queue = queue;
+    load_static_table(MBED_CONF_APP_NODE_NAMES);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef NAME_CACHE_H
+#define NAME_CACHE_H
+
+#include "mbed.h"
+
+/*
+ * Name to IPv6 address cache of mesh nodes, without DNS. A name is one of
+ *   - an IPv6 address literal, e.g. fd00:db8::ff:fe00:1
+ *   - a node name of the static table (node-names in mbed_app.json) or
+ *     added with name_cache_add(), e.g. sink
+ *   - an EUI-64 of 16 hex digits, optionally separated by '-', which is
+ *     combined with the /64 prefix of the own global address
+ */
+#define NAME_CACHE_NAME_MAX     24
+
+/** Result of name_cache_resolve(), called from the event queue */
+typedef mbed::Callback<void(nsapi_error_t, SocketAddress)> name_cache_callback_t;
+
+/**
+ * Load the static name table. Names are resolved from the event queue.
+ *
+ * \param interface_id Nanostack interface id of the mesh interface.
+ * \param queue Event queue the lookups and callbacks run from.
+ */
+void name_cache_init(int8_t interface_id, EventQueue *queue);
+
+/**
+ * Add or update a name. Entries added at run time are replaced least
+ * recently used first when the cache is full, static ones are kept.
+ *
+ * \return true on success
+ */
+bool name_cache_add(const char *name, const uint8_t address[16]);
+
+/**
+ * Look a name up without waiting.
+ *
+ * \return true if the name was resolved into address
+ */
+bool name_cache_lookup(const char *name, uint8_t address[16]);
+
+/**
+ * Resolve a name asynchronously. An EUI-64 that cannot be resolved yet,
+ * because the own global address is not ready, is retried until
+ * name-cache-timeout-ms has passed.
+ *
+ * \param name Name to resolve, copied.
+ * \param port Port of the resulting address.
+ * \param callback Called with NSAPI_ERROR_OK and the address, or with
+ *                 NSAPI_ERROR_DNS_FAILURE.
+ * \return NSAPI_ERROR_OK if the lookup was started, negative on failure
+ */
+nsapi_error_t name_cache_resolve(const char *name, uint16_t port, name_cache_callback_t callback);
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "rtos.h"
+#include "eventOS_scheduler.h"
+#include "ns_nvm_helper.h"
+#include "test_config.h"
+
+/*
+ * Stored through the Nanostack NVM helper on top of platform_nvm_*.
+ * The helper completes asynchronously on the event loop thread, the
+ * calling thread waits for the callback. After a timeout the request is
+ * still pending, and new ones are refused until its callback arrives.
+ */
+#define TEST_CONFIG_KEY             "com.arm.mesh.pingtest.config"
+#define TEST_CONFIG_NVM_TIMEOUT_MS  5000
+
+static Semaphore nvm_done(0);
+static int nvm_status;
+/* Must stay valid until the helper calls back */
+static test_config_t nvm_buffer;
+static uint16_t nvm_length;
+/* Request given to the helper and not called back, scheduler mutex held */
+static bool nvm_pending;
+
+static void nvm_callback(int status, void *context)
+{
+    (void)context;
+    nvm_status = status;
+    nvm_pending = false;
+    nvm_done.release();
+}
+
+/* Called with the scheduler mutex held, so the callback cannot run meanwhile */
+static bool nvm_idle(void)
+{
+    if (nvm_pending) {
+        return false;
+    }
+    // Drop the release of a request that timed out and completed later
+    nvm_done.wait(0);
+    return true;
+}
+
+static bool nvm_wait(int ret)
+{
+    if (ret != NS_NVM_OK) {
+        return false;
+    }
+    if (nvm_done.wait(TEST_CONFIG_NVM_TIMEOUT_MS) <= 0) {
+        return false;
+    }
+    return nvm_status == NS_NVM_OK;
+}
+
+bool test_config_load(test_config_t *config)
+{
+    int ret;
+
+    eventOS_scheduler_mutex_wait();
+    if (!nvm_idle()) {
+        eventOS_scheduler_mutex_release();
+        return false;
+    }
+    nvm_length = sizeof(nvm_buffer);
+    // Set first, a platform NVM may call back before the request returns
+    nvm_pending = true;
+    ret = ns_nvm_data_read(nvm_callback, TEST_CONFIG_KEY, (uint8_t *)&nvm_buffer, &nvm_length, NULL);
+    if (ret != NS_NVM_OK) {
+        nvm_pending = false;
+    }
+    eventOS_scheduler_mutex_release();
+
+    if (!nvm_wait(ret) || nvm_length != sizeof(nvm_buffer) || nvm_buffer.version != TEST_CONFIG_VERSION) {
+        return false;
+    }
+    *config = nvm_buffer;
+    config->destination[TEST_CONFIG_DESTINATION_MAX - 1] = '\0';
+    return true;
+}
+
+bool test_config_save(const test_config_t *config)
+{
+    int ret;
+
+    eventOS_scheduler_mutex_wait();
+    if (!nvm_idle()) {
+        eventOS_scheduler_mutex_release();
+        return false;
+    }
+    nvm_buffer = *config;
+    nvm_buffer.version = TEST_CONFIG_VERSION;
+    nvm_length = sizeof(nvm_buffer);
+    // Set first, a platform NVM may call back before the request returns
+    nvm_pending = true;
+    ret = ns_nvm_data_write(nvm_callback, TEST_CONFIG_KEY, (uint8_t *)&nvm_buffer, &nvm_length, NULL);
+    if (ret != NS_NVM_OK) {
+        nvm_pending = false;
+    }
+    eventOS_scheduler_mutex_release();
+
+    return nvm_wait(ret);
+}
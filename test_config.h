@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_CONFIG_H
+#define TEST_CONFIG_H
+
+#include <stdint.h>
+
+#define TEST_CONFIG_VERSION         1
+#define TEST_CONFIG_DESTINATION_MAX 48
+
+/** Test configuration entered on the console, persisted across reboots */
+typedef struct {
+    uint8_t version;
+    uint8_t action_mode;
+    char destination[TEST_CONFIG_DESTINATION_MAX];
+    int32_t send_length;
+    int32_t send_interval;
+    int32_t send_try;
+    int32_t receive_goal;
+    int32_t multicast_count;
+    int32_t multicast_interval_ms;
+    int32_t multicast_length;
+} test_config_t;
+
+/**
+ * Read the stored test configuration. Nanostack must be initialized.
+ *
+ * \return true if a configuration of the current version was found
+ */
+bool test_config_load(test_config_t *config);
+
+/**
+ * Store the test configuration. Nanostack must be initialized.
+ *
+ * \return true on success
+ */
+bool test_config_save(const test_config_t *config);
+
+#endif
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+"""
+Merge topology snapshots of the ping test application into one graph.
+
+Nodes print their snapshot as a hex encoded TOPO line at the end of a
+benchmark run, and serve it with CoAP GET coap://[node]/topo. Pass console
+logs (TOPO lines are picked out) or raw CoAP payloads (with --binary):
+
+    python topology_merge.py node1.log node2.log > mesh.dot
+    dot -Tpng mesh.dot -o mesh.png
+
+Edges point from a node to its RPL parents, labelled with the link cost
+(rank difference in hops) and the ETX of the primary parent. Thread nodes
+get an edge to their parent.
+"""
+from __future__ import print_function
+
+import argparse
+import binascii
+import socket
+import struct
+import sys
+
+TLV_NODE = 0x01
+TLV_RPL_DODAG = 0x02
+TLV_THREAD_PARENT = 0x03
+TLV_THREAD_LEADER = 0x04
+TLV_PARENT_ETX = 0x05
+TLV_NEIGHBOUR_TEXT = 0x06
+TLV_ROUTE_TEXT = 0x07
+
+RPL_PRIMARY_PARENT_SET = 1
+RPL_SECONDARY_PARENT_SET = 2
+
+
+def ipv6(data):
+    return socket.inet_ntop(socket.AF_INET6, bytes(data))
+
+
+def parse_snapshot(data):
+    if len(data) < 5 or data[0:2] != b"TS":
+        raise ValueError("not a topology snapshot")
+    version, sequence = struct.unpack(">BH", data[2:5])
+    snapshot = {"version": version, "sequence": sequence, "dodags": [],
+                "neighbours": "", "routes": ""}
+    offset = 5
+    while offset + 3 <= len(data):
+        tlv_type, length = struct.unpack(">BH", data[offset:offset + 3])
+        value = data[offset + 3:offset + 3 + length]
+        offset += 3 + length
+        if tlv_type == TLV_NODE and length >= 32:
+            snapshot["address"] = ipv6(value[0:16])
+            snapshot["link_local"] = ipv6(value[16:32])
+        elif tlv_type == TLV_RPL_DODAG and length >= 60:
+            instance = value[0:1]
+            dodag = {"instance": struct.unpack(">B", instance)[0],
+                     "dodag_id": ipv6(value[1:17])}
+            (dodag["version"], dodag["flags"], dodag["rank"],
+             dodag["min_hop_rank_inc"], dodag["parent_flags"]) = \
+                struct.unpack(">BBHHB", value[17:24])
+            dodag["primary_parent"] = ipv6(value[24:40])
+            dodag["primary_rank"] = struct.unpack(">H", value[40:42])[0]
+            dodag["secondary_parent"] = ipv6(value[42:58])
+            dodag["secondary_rank"] = struct.unpack(">H", value[58:60])[0]
+            snapshot["dodags"].append(dodag)
+        elif tlv_type == TLV_THREAD_PARENT and length >= 16:
+            snapshot["thread_parent"] = ipv6(value)
+        elif tlv_type == TLV_THREAD_LEADER and length >= 16:
+            snapshot["thread_leader"] = ipv6(value)
+        elif tlv_type == TLV_PARENT_ETX and length >= 4:
+            snapshot["etx"] = struct.unpack(">HH", value[0:4])
+        elif tlv_type == TLV_NEIGHBOUR_TEXT:
+            snapshot["neighbours"] = value.decode("ascii", "replace")
+        elif tlv_type == TLV_ROUTE_TEXT:
+            snapshot["routes"] = value.decode("ascii", "replace")
+    return snapshot
+
+
+def read_snapshots(paths, binary):
+    for path in paths:
+        if binary:
+            with open(path, "rb") as stream:
+                yield parse_snapshot(bytearray(stream.read()))
+            continue
+        with open(path) as stream:
+            # Latest snapshot of a node wins, so keep them all in order
+            for line in stream:
+                line = line.strip()
+                if line.startswith("TOPO,"):
+                    yield parse_snapshot(bytearray(binascii.unhexlify(line[5:])))
+
+
+def link_cost(dodag, parent_rank):
+    if not dodag["min_hop_rank_inc"]:
+        return None
+    return float(dodag["rank"] - parent_rank) / dodag["min_hop_rank_inc"]
+
+
+def write_dot(nodes, out):
+    link_locals = dict((node.get("link_local"), address) for address, node in nodes.items())
+    out.write("digraph mesh {\n")
+    for address, node in nodes.items():
+        label = address
+        if node.get("thread_leader") == address:
+            label += "\\nleader"
+        for dodag in node["dodags"]:
+            if dodag["dodag_id"] == address:
+                label += "\\nDODAG root"
+        out.write('  "%s" [label="%s"];\n' % (address, label))
+    for address, node in nodes.items():
+        etx = node.get("etx", (0, 0))
+        for dodag in node["dodags"]:
+            parents = []
+            if dodag["parent_flags"] & RPL_PRIMARY_PARENT_SET:
+                parents.append((dodag["primary_parent"], dodag["primary_rank"], etx[0], "solid"))
+            if dodag["parent_flags"] & RPL_SECONDARY_PARENT_SET:
+                parents.append((dodag["secondary_parent"], dodag["secondary_rank"], etx[1], "dashed"))
+            for parent, rank, parent_etx, style in parents:
+                label = []
+                cost = link_cost(dodag, rank)
+                if cost is not None:
+                    label.append("cost %.2f" % cost)
+                if parent_etx:
+                    label.append("etx %.2f" % (parent_etx / 128.0))
+                out.write('  "%s" -> "%s" [label="%s", style=%s];\n' % (
+                    address, parent, ", ".join(label), style))
+        parent = node.get("thread_parent")
+        if parent:
+            out.write('  "%s" -> "%s";\n' % (address, link_locals.get(parent, parent)))
+    out.write("}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("inputs", nargs="+", help="console logs, or snapshots with --binary")
+    parser.add_argument("--binary", action="store_true", help="inputs are raw CoAP payloads")
+    parser.add_argument("--tables", action="store_true",
+                        help="also print the neighbour and routing tables to stderr")
+    args = parser.parse_args()
+
+    nodes = {}
+    for snapshot in read_snapshots(args.inputs, args.binary):
+        if "address" in snapshot:
+            nodes[snapshot["address"]] = snapshot
+    if not nodes:
+        print("no topology snapshots found", file=sys.stderr)
+        return 1
+
+    if args.tables:
+        for address, node in nodes.items():
+            print("== %s neighbours\n%s\n== %s routes\n%s" % (
+                address, node["neighbours"], address, node["routes"]), file=sys.stderr)
+    write_dot(nodes, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include "mbed.h"
+#include "eventOS_scheduler.h"
+#include "common_functions.h"
+#include "nanostack/net_interface.h"
+#include "nanostack/net_rpl.h"
+#include "nanostack/thread_management_if.h"
+#include "topology_snapshot.h"
+#include "benchmark_report.h"
+#include "benchmark_coap.h"
+
+/*
+ * Nanostack has no public API to walk the neighbour and routing tables,
+ * only the arm_print_*2() functions. Their output is captured as text
+ * TLVs, which the host side tool parses.
+ *
+ * One snapshot is being built while the last finished one is served. The
+ * finished one is switched under the event loop mutex, which the CoAP
+ * callback runs with.
+ */
+#define TLV_HEADER_LEN          3
+#define SNAPSHOT_HEADER_LEN     5
+
+typedef enum {
+    STEP_NODE,
+    STEP_RPL_LIST,
+    STEP_RPL_DODAG,
+    STEP_THREAD,
+    STEP_PARENT_ETX,
+    STEP_NEIGHBOURS,
+    STEP_ROUTES,
+    STEP_DONE
+} snapshot_step_t;
+
+static int8_t network_interface_id = -1;
+static EventQueue *app_queue;
+static uint8_t snapshots[2][TOPOLOGY_SNAPSHOT_MAX];
+static uint16_t snapshot_length[2];
+static uint8_t latest;
+static uint16_t sequence;
+static bool in_progress;
+static bool print_done;
+static snapshot_step_t step;
+
+static uint8_t rpl_instances[64];
+static uint8_t rpl_instance_count;
+static uint8_t rpl_instance_index;
+static uint8_t rpl_instance_offset;
+
+/* Text capture state of the arm_print_*2() output */
+static uint8_t *capture_ptr;
+static uint16_t capture_space;
+
+static uint8_t *building(void)
+{
+    return snapshots[latest ^ 1];
+}
+
+static uint8_t *tlv_begin(uint8_t type, uint16_t length)
+{
+    uint16_t *used = &snapshot_length[latest ^ 1];
+    if (*used + TLV_HEADER_LEN + length > TOPOLOGY_SNAPSHOT_MAX) {
+        return NULL;
+    }
+    uint8_t *ptr = building() + *used;
+    *ptr++ = type;
+    ptr = common_write_16_bit(length, ptr);
+    *used += TLV_HEADER_LEN + length;
+    return ptr;
+}
+
+static void capture_print(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (capture_space <= 1) {
+        return;
+    }
+    va_start(ap, fmt);
+    int written = vsnprintf((char *)capture_ptr, capture_space, fmt, ap);
+    va_end(ap);
+    if (written < 0) {
+        return;
+    }
+    if (written >= capture_space) {
+        written = capture_space - 1;
+    }
+    capture_ptr += written;
+    capture_space -= written;
+}
+
+static void capture_text(uint8_t type, void (*print)(void (*print_fn)(const char *fmt, ...)))
+{
+    uint16_t *used = &snapshot_length[latest ^ 1];
+    if (*used + TLV_HEADER_LEN + 1 > TOPOLOGY_SNAPSHOT_MAX) {
+        return;
+    }
+    uint8_t *start = building() + *used + TLV_HEADER_LEN;
+    capture_ptr = start;
+    capture_space = TOPOLOGY_SNAPSHOT_MAX - *used - TLV_HEADER_LEN;
+    print(capture_print);
+
+    /* Length is only known after printing, the trailing NUL is dropped */
+    tlv_begin(type, capture_ptr - start);
+}
+
+static void step_node(void)
+{
+    uint8_t *ptr = building();
+    *ptr++ = 'T';
+    *ptr++ = 'S';
+    *ptr++ = TOPOLOGY_SNAPSHOT_VERSION;
+    common_write_16_bit(sequence, ptr);
+    snapshot_length[latest ^ 1] = SNAPSHOT_HEADER_LEN;
+
+    ptr = tlv_begin(TOPOLOGY_TLV_NODE, 32);
+    if (ptr) {
+        memset(ptr, 0, 32);
+        arm_net_address_get(network_interface_id, ADDR_IPV6_GP, ptr);
+        arm_net_address_get(network_interface_id, ADDR_IPV6_LL, ptr + 16);
+    }
+}
+
+static bool step_rpl_dodag(void)
+{
+    rpl_dodag_info_t info;
+
+    if (rpl_instance_index >= rpl_instance_count || rpl_instance_offset >= sizeof(rpl_instances)) {
+        return false;
+    }
+    rpl_instance_index++;
+    memset(&info, 0, sizeof(info));
+    uint8_t instance_id = rpl_instances[rpl_instance_offset++];
+    if (instance_id & RPL_INSTANCE_LOCAL) {
+        /* Local instances are followed by their DODAG ID */
+        if (rpl_instance_offset + 16 > sizeof(rpl_instances)) {
+            return false;
+        }
+        memcpy(info.dodag_id, &rpl_instances[rpl_instance_offset], 16);
+        rpl_instance_offset += 16;
+    }
+    if (!rpl_read_dodag_info(&info, instance_id)) {
+        return true;
+    }
+
+    uint8_t *ptr = tlv_begin(TOPOLOGY_TLV_RPL_DODAG, 60);
+    if (!ptr) {
+        return false;
+    }
+    *ptr++ = info.instance_id;
+    memcpy(ptr, info.dodag_id, 16);
+    ptr += 16;
+    *ptr++ = info.version_num;
+    *ptr++ = info.flags;
+    ptr = common_write_16_bit(info.curent_rank, ptr);
+    ptr = common_write_16_bit(info.dag_min_hop_rank_inc, ptr);
+    *ptr++ = info.parent_flags;
+    memcpy(ptr, info.primary_parent, 16);
+    ptr += 16;
+    ptr = common_write_16_bit(info.primary_parent_rank, ptr);
+    memcpy(ptr, info.secondary_parent, 16);
+    ptr += 16;
+    common_write_16_bit(info.secondary_parent_rank, ptr);
+    return true;
+}
+
+static void step_thread(void)
+{
+    uint8_t address[16];
+
+    if (thread_management_get_parent_address(network_interface_id, address) == 0) {
+        uint8_t *ptr = tlv_begin(TOPOLOGY_TLV_THREAD_PARENT, 16);
+        if (ptr) {
+            memcpy(ptr, address, 16);
+        }
+    }
+    if (thread_management_get_leader_address(network_interface_id, address) == 0) {
+        uint8_t *ptr = tlv_begin(TOPOLOGY_TLV_THREAD_LEADER, 16);
+        if (ptr) {
+            memcpy(ptr, address, 16);
+        }
+    }
+}
+
+static void step_parent_etx(void)
+{
+    nwk_stats_t stats;
+
+    benchmark_report_nwk_stats(&stats);
+    uint8_t *ptr = tlv_begin(TOPOLOGY_TLV_PARENT_ETX, 4);
+    if (ptr) {
+        ptr = common_write_16_bit(stats.etx_1st_parent, ptr);
+        common_write_16_bit(stats.etx_2nd_parent, ptr);
+    }
+}
+
+static void snapshot_print(void)
+{
+    static const char hex[] = "0123456789abcdef";
+    char line[65];
+    uint16_t length;
+    uint8_t *data;
+
+    eventOS_scheduler_mutex_wait();
+    length = snapshot_length[latest];
+    data = snapshots[latest];
+    eventOS_scheduler_mutex_release();
+
+    /* Runs from the event queue like the build steps, so the buffer cannot change meanwhile */
+    printf("TOPO,");
+    for (uint16_t i = 0; i < length; i += 32) {
+        uint16_t chunk = length - i < 32 ? length - i : 32;
+        for (uint16_t n = 0; n < chunk; n++) {
+            line[2 * n] = hex[data[i + n] >> 4];
+            line[2 * n + 1] = hex[data[i + n] & 0x0f];
+        }
+        line[2 * chunk] = '\0';
+        printf("%s", line);
+    }
+    printf("\n");
+}
+
+static void snapshot_step(void)
+{
+    bool more = true;
+
+    eventOS_scheduler_mutex_wait();
+    switch (step) {
+        case STEP_NODE:
+            step_node();
+            step = STEP_RPL_LIST;
+            break;
+        case STEP_RPL_LIST:
+            rpl_instance_index = 0;
+            rpl_instance_offset = 0;
+            rpl_instance_count = rpl_instance_list_read(rpl_instances, sizeof(rpl_instances));
+            step = STEP_RPL_DODAG;
+            break;
+        case STEP_RPL_DODAG:
+            /* One DODAG per step */
+            if (!step_rpl_dodag()) {
+                step = STEP_THREAD;
+            }
+            break;
+        case STEP_THREAD:
+            step_thread();
+            step = STEP_PARENT_ETX;
+            break;
+        case STEP_PARENT_ETX:
+            step_parent_etx();
+            step = STEP_NEIGHBOURS;
+            break;
+        case STEP_NEIGHBOURS:
+            capture_text(TOPOLOGY_TLV_NEIGHBOUR_TEXT, arm_print_neigh_cache2);
+            step = STEP_ROUTES;
+            break;
+        case STEP_ROUTES:
+            capture_text(TOPOLOGY_TLV_ROUTE_TEXT, arm_print_routing_table2);
+            step = STEP_DONE;
+            break;
+        case STEP_DONE:
+            latest ^= 1;
+            in_progress = false;
+            more = false;
+            break;
+    }
+    eventOS_scheduler_mutex_release();
+
+    if (more) {
+        app_queue->call(snapshot_step);
+    } else if (print_done) {
+        print_done = false;
+        snapshot_print();
+    }
+}
+
+void topology_snapshot_start(bool print)
+{
+    eventOS_scheduler_mutex_wait();
+    print_done = print_done || print;
+    if (in_progress || !app_queue) {
+        eventOS_scheduler_mutex_release();
+        return;
+    }
+    in_progress = true;
+    sequence++;
+    step = STEP_NODE;
+    eventOS_scheduler_mutex_release();
+
+    app_queue->call(snapshot_step);
+}
+
+static void snapshot_start_silent(void)
+{
+    topology_snapshot_start(false);
+}
+
+static int coap_format(char *buffer, size_t length)
+{
+    /* Called from the event loop thread */
+    uint16_t snapshot = snapshot_length[latest];
+    if (snapshot > length) {
+        return -1;
+    }
+    memcpy(buffer, snapshots[latest], snapshot);
+    if (!in_progress) {
+        app_queue->call(snapshot_start_silent);
+    }
+    return snapshot;
+}
+
+void topology_snapshot_init(int8_t interface_id, EventQueue *queue)
+{
+    network_interface_id = interface_id;
+    app_queue = queue;
+
+    eventOS_scheduler_mutex_wait();
+    benchmark_coap_register(TOPOLOGY_SNAPSHOT_COAP_URI, BENCHMARK_COAP_OCTET_STREAM, coap_format);
+    eventOS_scheduler_mutex_release();
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOPOLOGY_SNAPSHOT_H
+#define TOPOLOGY_SNAPSHOT_H
+
+#include "mbed.h"
+
+/*
+ * Snapshot format, all integers big endian:
+ *   'T' 'S' | version (8) | sequence (16) | TLV...
+ * TLV:
+ *   type (8) | length (16) | value
+ */
+#define TOPOLOGY_SNAPSHOT_VERSION       1
+#define TOPOLOGY_SNAPSHOT_MAX           1024
+#define TOPOLOGY_SNAPSHOT_COAP_URI      "topo"
+
+/* Own global address (16) | link local address (16) */
+#define TOPOLOGY_TLV_NODE               0x01
+/* Instance (8) | DODAG ID (16) | version (8) | flags (8) | rank (16) |
+ * min hop rank increase (16) | parent flags (8) |
+ * primary parent (16) | primary parent rank (16) |
+ * secondary parent (16) | secondary parent rank (16) */
+#define TOPOLOGY_TLV_RPL_DODAG          0x02
+/* Parent link local address (16) */
+#define TOPOLOGY_TLV_THREAD_PARENT      0x03
+/* Leader address (16) */
+#define TOPOLOGY_TLV_THREAD_LEADER      0x04
+/* Primary parent ETX (16) | secondary parent ETX (16), 128 = 1.0 */
+#define TOPOLOGY_TLV_PARENT_ETX         0x05
+/* arm_print_neigh_cache2() output, may be truncated */
+#define TOPOLOGY_TLV_NEIGHBOUR_TEXT     0x06
+/* arm_print_routing_table2() output, may be truncated */
+#define TOPOLOGY_TLV_ROUTE_TEXT         0x07
+
+/**
+ * Register the CoAP resource. A GET returns the last finished snapshot
+ * and starts the next one.
+ */
+void topology_snapshot_init(int8_t interface_id, EventQueue *queue);
+
+/**
+ * Start assembling a new snapshot. It is built in small steps from the
+ * event queue, so that the Nanostack event loop is only locked briefly.
+ *
+ * \param print Print the finished snapshot as a hex encoded TOPO line.
+ */
+void topology_snapshot_start(bool print);
+
+#endif